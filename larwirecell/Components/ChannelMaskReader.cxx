@@ -0,0 +1,40 @@
+#include "ChannelMaskReader.h"
+
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "larwirecell/DataProducts/ChannelMasks.h"
+
+#include "WireCellUtil/Exceptions.h"
+
+#include <iostream>
+
+using namespace WireCell;
+
+std::vector<art::InputTag> wcls::channel_mask_tags(Configuration jtags)
+{
+    std::vector<art::InputTag> ret;
+    for (auto jtag : jtags) {
+        ret.push_back(art::InputTag(jtag.asString()));
+    }
+    return ret;
+}
+
+void wcls::read_channel_masks(const art::Event& event, const std::vector<art::InputTag>& tags,
+                              Waveform::ChannelMaskMap& cmm)
+{
+    for (const auto& itag : tags) {
+        art::Handle<wcls::ChannelMasks> cmh;
+        if (!event.getByLabel(itag, cmh)) {
+            std::string msg = "wcls: failed to get wcls::ChannelMasks: " + itag.encode();
+            std::cerr << msg << std::endl;
+            THROW(RuntimeError() << errmsg{msg});
+        }
+        const std::string name = itag.instance().empty() ? itag.label() : itag.instance();
+        cmm[name] = cmh->AsMap();
+    }
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
@@ -0,0 +1,36 @@
+/** Read wcls::ChannelMasks products back into a WCT channel mask map
+ * for the frame sources.
+ */
+
+#ifndef LARWIRECELL_COMPONENTS_CHANNELMASKREADER
+#define LARWIRECELL_COMPONENTS_CHANNELMASKREADER
+
+#include "WireCellUtil/Configuration.h"
+#include "WireCellUtil/Waveform.h"
+
+#include "canvas/Utilities/InputTag.h"
+
+#include <vector>
+
+namespace art {
+    class Event;
+}
+
+namespace wcls {
+
+    /// Parse a list of art tags of wcls::ChannelMasks products.
+    std::vector<art::InputTag> channel_mask_tags(WireCell::Configuration jtags);
+
+    /// Add each product to cmm named by its instance name, or by its
+    /// label if it has none.  A missing product is an error.
+    void read_channel_masks(const art::Event& event, const std::vector<art::InputTag>& tags,
+                            WireCell::Waveform::ChannelMaskMap& cmm);
+
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
@@ -7,10 +7,16 @@
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Core/EDProducer.h"
 
+#include "larwirecell/Utilities/ChannelBuckets.h"
+#include "larwirecell/Utilities/Digitize.h"
+#include "larwirecell/Utilities/Sparsify.h"
+
 #include "WireCellIface/IFrame.h"
 #include "WireCellIface/ITrace.h"
 #include "WireCellUtil/NamedFactory.h"
 
+#include <algorithm>
+
 WIRECELL_FACTORY(wclsCookedFrameSink, wcls::CookedFrameSink, wcls::IArtEventVisitor, WireCell::IFrameSink)
 
 
@@ -49,6 +55,18 @@ void CookedFrameSink::configure(const WireCell::Configuration& cfg)
     // this throws if not found
     m_anode = Factory::find_tn<IAnodePlane>(anode_tn);
 
+    // FIXME: the current assumption in this code is that LS channel
+    // numbers are identified with WCT channel IDs.  The view is
+    // taken from the geometry and not the anode layer as eg the
+    // ICARUS induction-1 plane view is "geo::kY" instead of
+    // "geo::kU".
+    m_channels.clear();
+    m_views.clear();
+    m_chslot.clear();
+    for (auto chid : m_anode->channels()) {
+        add_channel(chid);
+    }
+
     auto jtags = cfg["frame_tags"];
     std::cerr << "CookedFrameSink: saving " << jtags.size() << " tags\n";
     for (auto jtag : jtags) {
@@ -59,6 +77,14 @@ void CookedFrameSink::configure(const WireCell::Configuration& cfg)
     m_nticks = get(cfg, "nticks", m_nticks);
 }
 
+void CookedFrameSink::add_channel(int chid)
+{
+    auto const& gc = *lar::providerFrom<geo::Geometry>();
+    ChannelBuckets::set_slot(m_chslot, chid, m_channels.size());
+    m_channels.push_back(chid);
+    m_views.push_back(gc.View(chid));
+}
+
 void CookedFrameSink::produces(art::ProducesCollector& collector)
 {
     for (auto tag : m_frame_tags) {
@@ -96,6 +122,8 @@ void CookedFrameSink::visit(art::Event & event)
 
     std::cerr << "CookedFrameSink: got " << m_frame->traces()->size() << " total traces\n";
 
+    std::vector<float> wave;
+
     for (auto tag : m_frame_tags) {
 
 	auto traces = tagged_traces(m_frame, tag);
@@ -104,42 +132,51 @@ void CookedFrameSink::visit(art::Event & event)
 	    continue;
 	}
 
+	// Channels unknown to the anode get slots after the known
+	// ones, as they are first met.
+	for (const auto& trace : traces) {
+	    const int chid = trace->channel();
+	    if (chid >= 0 and ChannelBuckets::slot_of(m_chslot, chid) < 0) {
+		add_channel(chid);
+	    }
+	}
+	const size_t nslots = m_channels.size();
+	ChannelBuckets::buckets_t bychan;
+	ChannelBuckets::bucket_by_slot(traces, m_chslot, nslots, bychan);
 
 	std::unique_ptr<std::vector<recob::Wire> > outwires(new std::vector<recob::Wire>);
 
 	// what about the frame's time() and ident()?
 
-	for (const auto& trace : traces) {
-
-	    const int tbin = trace->tbin();
-	    const int chid = trace->channel();
-	    const auto& charge = trace->charge();
-
-	    //std::cerr << tag << ": chid=" << chid << " tbin=" << tbin << " nq=" << charge.size() << std::endl;
+	for (size_t slot = 0; slot < nslots; ++slot) {
+	    if (!bychan.size(slot)) {
+		continue;
+	    }
 
-	    // enforce number of ticks if we are so configured.
-	    size_t ncharge = charge.size();
-	    int nticks = tbin + ncharge;
-	    if (m_nticks) {	// force output waveform size
-		if (m_nticks < nticks) {
-		    ncharge  = m_nticks - tbin;
+	    // Merge all traces of the channel.
+	    int nticks = m_nticks;
+	    if (!nticks) {
+		for (size_t ind = bychan.offset[slot]; ind < bychan.offset[slot+1]; ++ind) {
+		    const auto& trace = traces[bychan.index[ind]];
+		    nticks = std::max<int>(nticks, trace->tbin() + trace->charge().size());
 		}
-		nticks = m_nticks;
 	    }
-	    recob::Wire::RegionsOfInterest_t roi(nticks);
-	    roi.add_range(tbin, charge.begin(), charge.begin() + ncharge);
+	    wave.assign(nticks, 0.0);
+	    for (size_t ind = bychan.offset[slot]; ind < bychan.offset[slot+1]; ++ind) {
+		// clipped to the frame at both ends
+		const auto& trace = traces[bychan.index[ind]];
+		const auto& charge = trace->charge();
+		Digitize::accumulate(wave, trace->tbin(), charge.data(), charge.size());
+	    }
 
-		// FIXME: the current assumption in this code is that LS channel
-		// numbers are identified with WCT channel IDs.
-		// Fact: the plane view for the ICARUS induction-1 is "geo::kY",
-		// instead of "geo::kU"
-		auto const& gc = *lar::providerFrom<geo::Geometry>();
-		auto view = gc.View(chid);
+	    // Keep only the nonzero runs.
+	    recob::Wire::RegionsOfInterest_t roi(nticks);
+	    Sparsify::add_nonzero_runs(roi, 0, wave.data(), wave.size());
 
 	    // what about those pesky channel map masks?
 	    // they are dropped for now.
 
-	    outwires->emplace_back(recob::Wire(roi, chid, view));
+	    outwires->emplace_back(recob::Wire(roi, m_channels[slot], m_views[slot]));
 	}
 	std::cerr << "CookedFrameSink saving " << outwires->size() << " recob::Wires named \""<<tag<<"\"\n";
 	event.put(std::move(outwires), tag);
@@ -3,6 +3,10 @@
  *
  * Cooked means that some processing of the frame has occurred and the
  * frame is saved into the art::Event as recob::Wires.
+ *
+ * All traces of a channel are merged into one recob::Wire holding
+ * only the nonzero runs of samples.  The wires are in the channel
+ * order of the anode, followed by any channels not in the anode.
  */
 
 #ifndef LARWIRECELL_COMPONENTS_COOKEDFRAMESINK
@@ -12,6 +16,7 @@
 #include "WireCellIface/IConfigurable.h"
 #include "WireCellIface/IAnodePlane.h"
 #include "larwirecell/Interfaces/IArtEventVisitor.h"
+#include "larcoreobj/SimpleTypesAndConstants/geo_types.h"
 
 #include <string>
 #include <vector>
@@ -40,6 +45,14 @@ namespace wcls {
         WireCell::IAnodePlane::pointer m_anode;
 	std::vector<std::string> m_frame_tags;
 	int m_nticks;
+
+        // Channels in output order, by slot, and their views, and
+        // a dense channel ID to slot lookup.  The anode's channels
+        // come first, then any others as they are met.
+        std::vector<int> m_channels;
+        std::vector<geo::View_t> m_views;
+        std::vector<int> m_chslot;
+        void add_channel(int chid);
     };
 }
 
@@ -1,8 +1,10 @@
 #include "CookedFrameSource.h"
+#include "ChannelMaskReader.h"
 #include "art/Framework/Principal/Handle.h"
 
 #include "art/Framework/Principal/Event.h"
 #include "lardataobj/RecoBase/Wire.h"
+#include "larwirecell/DataProducts/QuantizedWire.h"
 
 #include "TTimeStamp.h"
 
@@ -10,6 +12,10 @@
 #include "WireCellIface/SimpleTrace.h"
 #include "WireCellUtil/NamedFactory.h"
 
+#include "tbb/parallel_for.h"
+
+#include <algorithm>
+
 WIRECELL_FACTORY(wclsCookedFrameSource,
                  wcls::CookedFrameSource,
                  wcls::IArtEventVisitor,
@@ -18,7 +24,7 @@ WIRECELL_FACTORY(wclsCookedFrameSource,
 using namespace wcls;
 using namespace WireCell;
 
-CookedFrameSource::CookedFrameSource() : m_nticks(0) {}
+CookedFrameSource::CookedFrameSource() : m_nticks(0), m_sparse(false), m_quantized(false) {}
 
 CookedFrameSource::~CookedFrameSource() {}
 
@@ -27,26 +33,81 @@ CookedFrameSource::default_configuration() const
 {
   Configuration cfg;
   cfg["art_tag"] = ""; // how to look up the cooked digits
+  // Alternatively, a list of art tags.  All collections are read
+  // into one frame and the traces of each are tagged.
+  cfg["art_tags"] = Json::arrayValue;
+  // Trace tags, one per art_tags entry.  Defaults to the instance
+  // name (or label if no instance) of the art tag.
+  cfg["trace_tags"] = Json::arrayValue;
+  // Optional art tags of per-wire std::vector<double> summaries, one
+  // per art_tags entry, "" for none.  The summary must be in the
+  // order of the wires, as FrameSaver writes them.
+  cfg["summary_tags"] = Json::arrayValue;
   cfg["tick"] = 0.5 * WireCell::units::us;
   cfg["frame_tags"][0] = "orig"; // the tags to apply to this frame
   cfg["nticks"] = m_nticks;      // if nonzero, truncate or zero-pad frame to this number of ticks.
+  // If true, make one trace per ROI of each recob::Wire instead of
+  // one zero-padded, full length trace per wire.
+  cfg["sparse"] = m_sparse;
+  // The type of the art collections, "wire" for recob::Wire or
+  // "quantized" for wcls::QuantizedWire.
+  cfg["format"] = "wire";
+  // Art tags of wcls::ChannelMasks products, as FrameSaver writes
+  // with cmm_format "compact", to give to the frame as channel mask
+  // maps named by instance (or label).
+  cfg["cmm_tags"] = Json::arrayValue;
   return cfg;
 }
 
 void
 CookedFrameSource::configure(const WireCell::Configuration& cfg)
 {
-  const std::string art_tag = cfg["art_tag"].asString();
-  if (art_tag.empty()) {
-    THROW(ValueError() << errmsg{"WireCell::CookedFrameSource requires a source_label"});
+  m_inputTags.clear();
+  m_trace_tags.clear();
+  m_summaryTags.clear();
+
+  auto jtags = cfg["art_tags"];
+  if (jtags.isArray() and jtags.size() > 0) {
+    auto jttags = cfg["trace_tags"];
+    auto jstags = cfg["summary_tags"];
+    for (Json::ArrayIndex ind = 0; ind < jtags.size(); ++ind) {
+      art::InputTag itag(jtags[ind].asString());
+      std::string ttag = itag.instance().empty() ? itag.label() : itag.instance();
+      if (jttags.isArray() and ind < jttags.size()) { ttag = jttags[ind].asString(); }
+      std::string stag = "";
+      if (jstags.isArray() and ind < jstags.size()) { stag = jstags[ind].asString(); }
+      m_inputTags.push_back(itag);
+      m_trace_tags.push_back(ttag);
+      m_summaryTags.push_back(art::InputTag(stag));
+    }
+  }
+  else {
+    const std::string art_tag = cfg["art_tag"].asString();
+    if (art_tag.empty()) {
+      THROW(ValueError() << errmsg{"WireCell::CookedFrameSource requires a source_label"});
+    }
+    // a single collection is not trace tagged
+    m_inputTags.push_back(art::InputTag(art_tag));
+    m_trace_tags.push_back("");
+    m_summaryTags.push_back(art::InputTag(""));
   }
-  m_inputTag = cfg["art_tag"].asString();
 
   m_tick = cfg["tick"].asDouble();
   for (auto jtag : cfg["frame_tags"]) {
     m_frame_tags.push_back(jtag.asString());
   }
   m_nticks = get(cfg, "nticks", m_nticks);
+  m_sparse = get(cfg, "sparse", m_sparse);
+
+  const std::string format = get<std::string>(cfg, "format", "wire");
+  if (format == "wire") { m_quantized = false; }
+  else if (format == "quantized") {
+    m_quantized = true;
+  }
+  else {
+    THROW(ValueError() << errmsg{"WireCell::CookedFrameSource unknown format: " + format});
+  }
+  m_cmm_tags = channel_mask_tags(cfg["cmm_tags"]);
 }
 
 // this code assumes that the high part of timestamp represents number of seconds from Jan 1st, 1970 and the low part
@@ -59,30 +120,139 @@ tdiff(const art::Timestamp& ts1, const art::Timestamp& ts2)
   return tts2.AsDouble() - tts1.AsDouble();
 }
 
-static SimpleTrace*
-make_trace(const recob::Wire& rw, unsigned int nticks_want)
+// The ROIs of a wire.  Those of a QuantizedWire are views of its
+// quantized samples, so neither form copies samples here.
+static const std::vector<recob::Wire::RegionsOfInterest_t::datarange_t>&
+wire_rois(const recob::Wire& rw)
+{
+  return rw.SignalROI().get_ranges();
+}
+static std::vector<QuantizedWire::ROI>
+wire_rois(const QuantizedWire& qw)
+{
+  return qw.ROIs();
+}
+
+// Copy the first n samples of an ROI.
+static void
+roi_samples(const recob::Wire::RegionsOfInterest_t::datarange_t& range, size_t n, float* out)
+{
+  std::copy(range.begin(), range.begin() + n, out);
+}
+static void
+roi_samples(const QuantizedWire::ROI& roi, size_t n, float* out)
+{
+  for (size_t ind = 0; ind < n; ++ind) {
+    out[ind] = roi[ind];
+  }
+}
+
+// Add the trace(s) for one wire, a recob::Wire or a QuantizedWire.
+// Dense mode makes one full length trace per wire, filled directly
+// from its ROIs.  Sparse mode makes one trace per ROI and none for a
+// wire without ROIs.
+template <typename WireType>
+static void
+make_traces(const WireType& rw, unsigned int nticks_want, bool sparse, ITrace::vector& traces)
 {
   // uint
   const raw::ChannelID_t chid = rw.Channel();
-  const int tbin = 0;
-  const std::vector<float> sig = rw.Signal();
+  const auto& ranges = wire_rois(rw);
 
-  const float baseline = 0.0;
-  unsigned int nsamp = sig.size();
+  unsigned int nsamp = rw.NSignal();
   if (nticks_want > 0) { nsamp = std::min(nsamp, nticks_want); }
   else {
     nticks_want = nsamp;
   }
 
-  auto strace = new SimpleTrace(chid, tbin, nticks_want);
-  auto& q = strace->charge();
-  for (unsigned int itick = 0; itick < nsamp; ++itick) {
-    q[itick] = sig[itick];
+  if (!sparse) {
+    // zero baseline
+    auto strace = new SimpleTrace(chid, 0, nticks_want);
+    auto& q = strace->charge();
+    for (const auto& range : ranges) {
+      const unsigned int beg = range.begin_index();
+      if (beg >= nsamp) { continue; }
+      const unsigned int end = std::min<unsigned int>(range.end_index(), nsamp);
+      roi_samples(range, end - beg, q.data() + beg);
+    }
+    traces.push_back(ITrace::pointer(strace));
+    return;
+  }
+
+  for (const auto& range : ranges) {
+    const unsigned int beg = range.begin_index();
+    if (beg >= nsamp) { continue; }
+    const unsigned int end = std::min<unsigned int>(range.end_index(), nsamp);
+    ITrace::ChargeSequence q(end - beg);
+    roi_samples(range, end - beg, q.data());
+    traces.push_back(std::make_shared<SimpleTrace>(chid, beg, q));
+  }
+}
+
+template <typename WireType>
+size_t
+CookedFrameSource::read_collections(const art::Event& event,
+                                    std::vector<ITrace::vector>& colltraces,
+                                    std::vector<IFrame::trace_summary_t>& collsums) const
+{
+  // Data products are fetched serially, only the conversion is
+  // shared out.
+  const size_t ncolls = m_inputTags.size();
+  std::vector<art::Handle<std::vector<WireType>>> rwvhs(ncolls);
+  std::vector<art::Handle<std::vector<double>>> sumhs(ncolls);
+  size_t nwires = 0;
+  for (size_t icoll = 0; icoll < ncolls; ++icoll) {
+    const auto& itag = m_inputTags[icoll];
+    bool okay = event.getByLabel(itag, rwvhs[icoll]);
+    if (!okay) {
+      std::string msg = "WireCell::CookedFrameSource failed to get wire collection: " +
+                        itag.encode();
+      std::cerr << msg << std::endl;
+      THROW(RuntimeError() << errmsg{msg});
+    }
+    nwires += rwvhs[icoll]->size();
+    std::cerr << "CookedFrameSource: got " << rwvhs[icoll]->size() << " wires from "
+              << itag.encode() << "\n";
+
+    const auto& stag = m_summaryTags[icoll];
+    if (stag.label().empty()) { continue; }
+    okay = event.getByLabel(stag, sumhs[icoll]);
+    if (!okay) {
+      std::string msg =
+        "WireCell::CookedFrameSource failed to get vector<double>: " + stag.encode();
+      std::cerr << msg << std::endl;
+      THROW(RuntimeError() << errmsg{msg});
+    }
+    if (sumhs[icoll]->size() != rwvhs[icoll]->size()) {
+      std::string msg = "WireCell::CookedFrameSource summary " + stag.encode() +
+                        " does not match wires " + itag.encode();
+      std::cerr << msg << std::endl;
+      THROW(RuntimeError() << errmsg{msg});
+    }
   }
-  for (unsigned int itick = nsamp; itick < nticks_want; ++itick) {
-    q[itick] = baseline;
+  if (nwires == 0) return 0;
+
+  if (m_nticks) {
+    std::cerr << "\tsetting nticks to " << m_nticks << std::endl;
   }
-  return strace;
+  else {
+    std::cerr << "\tkeeping input nticks" << std::endl;
+  }
+
+  colltraces.resize(ncolls);
+  collsums.resize(ncolls);
+  tbb::parallel_for(size_t(0), ncolls, [&](size_t icoll) {
+    const std::vector<WireType>& rwv(*rwvhs[icoll]);
+    const bool has_summary = sumhs[icoll].isValid();
+    auto& traces = colltraces[icoll];
+    auto& summary = collsums[icoll];
+    traces.reserve(rwv.size());
+    for (size_t ind = 0; ind < rwv.size(); ++ind) {
+      make_traces(rwv[ind], m_nticks, m_sparse, traces);
+      if (has_summary) { summary.resize(traces.size(), sumhs[icoll]->at(ind)); }
+    }
+  });
+  return nwires;
 }
 
 void
@@ -91,41 +261,43 @@ CookedFrameSource::visit(art::Event& e)
   auto const& event = e;
   // fixme: want to avoid depending on DetectorPropertiesService for now.
   const double tick = m_tick;
-  art::Handle<std::vector<recob::Wire>> rwvh;
-  bool okay = event.getByLabel(m_inputTag, rwvh);
-  if (!okay) {
-    std::string msg =
-      "WireCell::CookedFrameSource failed to get vector<recob::Wire>: " + m_inputTag.encode();
-    std::cerr << msg << std::endl;
-    THROW(RuntimeError() << errmsg{msg});
-  }
-  else if (rwvh->size() == 0)
-    return;
 
-  const std::vector<recob::Wire>& rwv(*rwvh);
-  const size_t nchannels = rwv.size();
-  std::cerr << "CookedFrameSource: got " << nchannels << " recob::Wire objects\n";
-
-  WireCell::ITrace::vector traces(nchannels);
-  for (size_t ind = 0; ind < nchannels; ++ind) {
-    auto const& rw = rwv.at(ind);
-    traces[ind] = ITrace::pointer(make_trace(rw, m_nticks));
-    if (!ind) { // first time through
-      if (m_nticks) {
-        std::cerr << "\tinput nticks=" << rw.NSignal() << " setting to " << m_nticks << std::endl;
-      }
-      else {
-        std::cerr << "\tinput nticks=" << rw.NSignal() << " keeping as is" << std::endl;
-      }
+  const size_t ncolls = m_inputTags.size();
+  std::vector<ITrace::vector> colltraces;
+  std::vector<IFrame::trace_summary_t> collsums;
+  size_t nwires = 0;
+  if (m_quantized) { nwires = read_collections<QuantizedWire>(event, colltraces, collsums); }
+  else {
+    nwires = read_collections<recob::Wire>(event, colltraces, collsums);
+  }
+  if (nwires == 0) return;
+
+  WireCell::ITrace::vector traces;
+  traces.reserve(nwires);
+  std::vector<IFrame::trace_list_t> collinds(ncolls);
+  for (size_t icoll = 0; icoll < ncolls; ++icoll) {
+    for (auto& trace : colltraces[icoll]) {
+      collinds[icoll].push_back(traces.size());
+      traces.push_back(trace);
     }
   }
+  if (m_sparse) {
+    std::cerr << "\tmade " << traces.size() << " sparse traces\n";
+  }
+
+  Waveform::ChannelMaskMap cmm;
+  read_channel_masks(event, m_cmm_tags, cmm);
 
   const double time = tdiff(event.getRun().beginTime(), event.time());
-  auto sframe = new WireCell::SimpleFrame(event.event(), time, traces, tick);
+  auto sframe = new WireCell::SimpleFrame(event.event(), time, traces, tick, cmm);
   for (auto tag : m_frame_tags) {
     //std::cerr << "\ttagged: " << tag << std::endl;
     sframe->tag_frame(tag);
   }
+  for (size_t icoll = 0; icoll < ncolls; ++icoll) {
+    if (m_trace_tags[icoll].empty()) { continue; }
+    sframe->tag_traces(m_trace_tags[icoll], collinds[icoll], collsums[icoll]);
+  }
   m_frames.push_back(WireCell::IFrame::pointer(sframe));
   m_frames.push_back(nullptr);
 }
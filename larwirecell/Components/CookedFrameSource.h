@@ -2,7 +2,17 @@
  * produces by also being an art::Event visitor.
  *
  * Cooked means that the waveforms are taken from the art::Event as a
- * labeled std::vector<recob::Wire> collection.
+ * labeled std::vector<recob::Wire> collection or, with format
+ * "quantized", std::vector<wcls::QuantizedWire>.
+ *
+ * By default each wire becomes a dense trace.  In "sparse" mode each
+ * ROI of a wire becomes a trace starting at the ROI's tick so memory
+ * follows the signal content rather than channels x ticks.
+ *
+ * Several collections (eg "gauss" and "wiener") may be read into one
+ * frame, converted in parallel, with the traces of each collection
+ * given a trace tag and, optionally, per-wire summary values.  This
+ * is the shape of what FrameSaver writes.
  */
 
 #ifndef LARWIRECELL_COMPONENTS_COOKEDFRAMESOURCE
@@ -38,10 +48,21 @@ namespace wcls {
 
   private:
     std::deque<WireCell::IFrame::pointer> m_frames;
-    art::InputTag m_inputTag;
+    // one entry per input collection
+    std::vector<art::InputTag> m_inputTags, m_summaryTags, m_cmm_tags;
+    std::vector<std::string> m_trace_tags;
     double m_tick;
     int m_nticks;
+    bool m_sparse, m_quantized;
     std::vector<std::string> m_frame_tags;
+
+    // Convert the configured collections of WireType to traces and
+    // summaries, one entry per collection.  Return the number of
+    // wires read.
+    template <typename WireType>
+    size_t read_collections(const art::Event& event,
+                            std::vector<WireCell::ITrace::vector>& colltraces,
+                            std::vector<WireCell::IFrame::trace_summary_t>& collsums) const;
   };
 
 }
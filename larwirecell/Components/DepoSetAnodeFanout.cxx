@@ -0,0 +1,97 @@
+#include "DepoSetAnodeFanout.h"
+#include "SimDepoSource.h"
+
+#include "WireCellUtil/Exceptions.h"
+#include "WireCellUtil/NamedFactory.h"
+#include "WireCellIface/SimpleDepoSet.h"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
+#include <cstdint>
+#include <typeinfo>
+
+WIRECELL_FACTORY(wclsDepoSetAnodeFanout, wcls::DepoSetAnodeFanout,
+                 WireCell::IDepoSetFanout, WireCell::IConfigurable)
+
+using namespace wcls;
+
+DepoSetAnodeFanout::DepoSetAnodeFanout()
+{
+}
+
+DepoSetAnodeFanout::~DepoSetAnodeFanout()
+{
+}
+
+WireCell::Configuration DepoSetAnodeFanout::default_configuration() const
+{
+    WireCell::Configuration cfg;
+    // IAnodePlane type:names, one output per anode in this order.
+    cfg["anodes"] = Json::arrayValue;
+    // Grow each face's sensitive volume by this in every direction.
+    cfg["margin"] = 0.0;
+    return cfg;
+}
+
+void DepoSetAnodeFanout::configure(const WireCell::Configuration& cfg)
+{
+    const double margin = WireCell::get(cfg, "margin", 0.0);
+    m_boxes.clear();
+    for (auto janode : cfg["anodes"]) {
+        m_boxes.push_back(SimDepoSource::sensitive_boxes(janode.asString(), margin));
+    }
+    if (m_boxes.empty() or m_boxes.size() > 64) {
+        THROW(WireCell::ValueError() << WireCell::errmsg{"DepoSetAnodeFanout: need 1 to 64 anodes"});
+    }
+}
+
+std::vector<std::string> DepoSetAnodeFanout::output_types()
+{
+    const std::string tname = std::string(typeid(output_type).name());
+    return std::vector<std::string>(m_boxes.size(), tname);
+}
+
+bool DepoSetAnodeFanout::operator()(const input_pointer& in, output_vector& outv)
+{
+    const size_t nanodes = m_boxes.size();
+    outv.resize(nanodes);
+    if (!in) {                  // EOS to all
+        for (auto& out : outv) {
+            out = nullptr;
+        }
+        return true;
+    }
+
+    // One bit per anode for each depo, found in parallel.
+    const auto& depos = *in->depos();
+    const size_t ndepos = depos.size();
+    std::vector<uint64_t> where(ndepos, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, ndepos),
+                      [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t ind=r.begin(); ind != r.end(); ++ind) {
+            const WireCell::Point pt = depos[ind]->pos();
+            for (size_t ianode=0; ianode<nanodes; ++ianode) {
+                for (const auto& box : m_boxes[ianode]) {
+                    if (box.inside(pt)) {
+                        where[ind] |= uint64_t(1) << ianode;
+                        break;
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<WireCell::IDepo::vector> routed(nanodes);
+    for (size_t ind=0; ind<ndepos; ++ind) {
+        for (size_t ianode=0; ianode<nanodes; ++ianode) {
+            if (where[ind] & (uint64_t(1) << ianode)) {
+                routed[ianode].push_back(depos[ind]);
+            }
+        }
+    }
+    for (size_t ianode=0; ianode<nanodes; ++ianode) {
+        outv[ianode] = std::make_shared<WireCell::SimpleDepoSet>(in->ident(), routed[ianode]);
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+/** Route the depos of each depo set to one output per anode.
+
+    Each depo is classified once against the sensitive volumes of the
+    faces of the configured anodes, grown by a margin, and goes to
+    the output of every anode which contains it.  Depos in no anode
+    are dropped.  Every input set gives one set on each output, which
+    may be empty, and an end-of-stream goes to all outputs.
+
+    Use it after a wclsSimDepoSetSource to feed per-anode parts of a
+    graph from one conversion of the art::Event.
+*/
+
+#ifndef LARWIRECELL_COMPONENTS_DEPOSETANODEFANOUT
+#define LARWIRECELL_COMPONENTS_DEPOSETANODEFANOUT
+
+#include "WireCellIface/IDepoSetFanout.h"
+#include "WireCellIface/IConfigurable.h"
+#include "WireCellUtil/BoundingBox.h"
+
+#include <vector>
+
+namespace wcls {
+
+    class DepoSetAnodeFanout : public WireCell::IDepoSetFanout,
+                               public WireCell::IConfigurable {
+    public:
+        DepoSetAnodeFanout();
+        virtual ~DepoSetAnodeFanout();
+
+        /// IDepoSetFanout
+        virtual std::vector<std::string> output_types();
+        virtual bool operator()(const input_pointer& in, output_vector& outv);
+
+        /// IConfigurable
+        virtual WireCell::Configuration default_configuration() const;
+        virtual void configure(const WireCell::Configuration& config);
+
+    private:
+        // the sensitive boxes of each anode, in output order
+        std::vector<std::vector<WireCell::BoundingBox>> m_boxes;
+    };
+}
+#endif
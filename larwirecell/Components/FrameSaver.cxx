@@ -4,10 +4,22 @@
 #include "FrameSaver.h"
 
 #include "lardataobj/RawData/RawDigit.h"
+#include "lardataobj/RawData/raw.h"
 #include "lardataobj/RecoBase/Wire.h"
+#include "larwirecell/DataProducts/ChannelMasks.h"
+#include "larwirecell/DataProducts/QuantizedWire.h"
 
 #include "art/Framework/Core/EDProducer.h"
 #include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Handle.h"
+#include "art/Persistency/Common/PtrMaker.h"
+
+#include "larwirecell/Utilities/AdcStats.h"
+#include "larwirecell/Utilities/ChannelBuckets.h"
+#include "larwirecell/Utilities/Digitize.h"
+#include "larwirecell/Utilities/NpzWriter.h"
+#include "larwirecell/Utilities/RawAdcs.h"
+#include "larwirecell/Utilities/Sparsify.h"
 
 #include "WireCellIface/IAnodePlane.h"
 #include "WireCellIface/IFrame.h"
@@ -20,15 +32,35 @@
 #include "larevt/CalibrationDBI/Interface/DetPedestalProvider.h"
 #include "larevt/CalibrationDBI/Interface/DetPedestalService.h"
 
+#include "tbb/parallel_for.h"
+
 #include <algorithm>
+#include <cmath>
 #include <map>
+#include <numeric>
+#include <sstream>
 
 WIRECELL_FACTORY(wclsFrameSaver, wcls::FrameSaver, wcls::IArtEventVisitor, WireCell::IFrameFilter)
 
 using namespace wcls;
 using namespace WireCell;
 
-FrameSaver::FrameSaver() : m_frame(nullptr), m_nticks(0) {}
+FrameSaver::FrameSaver()
+  : m_nticks(0)
+  , m_quantized(false)
+  , m_quantize_step(0.1)
+  , m_raw_empty(false)
+  , m_zs(false)
+  , m_zs_pre(0)
+  , m_zs_post(0)
+  , m_zs_min_length(0)
+  , m_zs_summary_scale(1.0)
+  , m_cmm_legacy(true)
+  , m_cmm_compact(false)
+  , m_compression(raw::kNone)
+  , m_compress_threshold(5)
+  , m_compress_nearest_neighbor(4)
+{}
 
 FrameSaver::~FrameSaver() {}
 
@@ -47,6 +79,49 @@ FrameSaver::default_configuration() const
   // the input IFrame itself is sparse or not.
   cfg["sparse"] = true;
 
+  // If sparse, recob::Wires may instead be threshold zero
+  // suppressed.  These options are ignored, with a warning, if not
+  // sparse.  A region of samples with magnitude above threshold
+  // is kept if it is at least zs_min_length ticks long and is then
+  // padded by zs_pad ticks.  The threshold is compared to samples
+  // before any frame_scale and may be one number or a list of
+  // three, one per U, V, W plane.  Zero threshold, padding and
+  // minimum length keep only the removal of exact zeros.
+  cfg["zs_threshold"] = 0.0;
+  // A number of ticks or a [pre, post] pair.
+  cfg["zs_pad"] = 0;
+  cfg["zs_min_length"] = 0;
+  // If set, the tag of a trace summary holding thresholds, such as
+  // that produced by signal processing.  These values, multiplied
+  // by zs_summary_scale, replace zs_threshold on channels which
+  // have one.  Where a channel has several the largest is used.
+  cfg["zs_summary"] = "";
+  cfg["zs_summary_scale"] = 1.0;
+
+  // If not digitize, the format of the cooked waveforms.  Either
+  // "wire" for recob::Wire or "quantized" for wcls::QuantizedWire
+  // which stores ROI samples as short integers in steps of
+  // quantize_step (after frame_scale).  A channel with samples too
+  // large for this step is given a coarser one.
+  cfg["cooked_format"] = "wire";
+  cfg["quantize_step"] = 0.1;
+
+  // If saving recob::Wire, also make art::Assns<raw::RawDigit,
+  // recob::Wire> named as the frame tag for each frame tag key of
+  // these objects.  Wires and digits are paired by channel.
+  //
+  // The values of assn_raw_instances name a raw::RawDigit
+  // collection put by the digitizing FrameSaver given by
+  // assn_raw_saver as "type:name".  It must be in the same art
+  // module and visited first.  Its digits are paired by index so it
+  // must have put one per channel of this saver, in the same order.
+  // Otherwise, as when it had no frames, it is an error.
+  cfg["assn_raw_instances"] = Json::objectValue;
+  cfg["assn_raw_saver"] = "";
+  // The values of assn_raw_tags are art tags of raw::RawDigit
+  // collections already in the event.
+  cfg["assn_raw_tags"] = Json::objectValue;
+
   // If digitize, raw::RawDigit has slots for pedestal mean and
   // sigma.  Legacy/obsolete code stuff unrelated values into these
   // slots.  If pedestal_mean is a number, it will be stuffed.  If
@@ -57,6 +132,24 @@ FrameSaver::default_configuration() const
   // to do with the produced NF'ed waveforms.
   cfg["pedestal_sigma"] = 0.0;
 
+  // If digitize, all traces of a channel are summed, scaled and
+  // converted to ADC by "round" (to nearest) or "truncate" (toward
+  // zero) and saturated to the inclusive range [adc_min, adc_max].
+  cfg["digitize_rounding"] = "round";
+  cfg["adc_min"] = -32768;
+  cfg["adc_max"] = 32767;
+
+  // If digitize, the raw::RawDigit ADCs may be compressed as
+  // "none", "huffman", "zs" (zero suppressed) or "zs_huffman".
+  // Zero suppression keeps samples which differ from the saved
+  // pedestal by at least compress_threshold and, around them,
+  // compress_nearest_neighbor samples.  Use "native" pedestal_mean
+  // or a value matching the waveform baseline with "zs".  The
+  // readers of this package uncompress with RawAdcs::samples().
+  cfg["compression"] = "none";
+  cfg["compress_threshold"] = 5;
+  cfg["compress_nearest_neighbor"] = 4;
+
   // frames to output, if any
   cfg["frame_tags"] = Json::arrayValue;
   cfg["frame_scale"] = 1.0; // multiply this number to all
@@ -77,27 +170,30 @@ FrameSaver::default_configuration() const
   // common channel.  The operator is defined as an object keyed by
   // the summary tag.  Values may be "set" which will simply save a
   // summary value to the output element (last one from a channel
-  // wins) or "sum" (the default) which will add up the values.
+  // wins), "sum" (the default) which will add up the values, "min",
+  // "max", "mean" or "count" (the number of values).  Channels
+  // without any value get zero.
   cfg["summary_operator"] = Json::objectValue;
 
   // Names of channel mask maps to save, if any.
   cfg["chanmaskmaps"] = Json::arrayValue;
+  // How to save channel mask maps: "legacy" as the two vector<int>
+  // described in FrameSaver.h, "compact" as one wcls::ChannelMasks
+  // named as the map, or "both".
+  cfg["cmm_format"] = "legacy";
+
+  // If set, also write one NumPy file per event named
+  // <npz_prefix>_<run>_<subrun>_<event>.npz.  For each of npz_tags
+  // (default is all frame_tags) it holds frame_<tag>, the waveforms
+  // as saved to art as a float32 channels x ticks array, and
+  // channels_<tag> and tickinfo_<tag> (time of the earliest frame
+  // and tick).  Each summary tag gives an array summary_<tag>.
+  cfg["npz_prefix"] = "";
+  cfg["npz_tags"] = Json::arrayValue;
 
   return cfg;
 }
 
-static float
-summary_sum(const std::vector<float>& tsvals)
-{
-  return std::accumulate(tsvals.begin(), tsvals.end(), 0);
-}
-static float
-summary_set(const std::vector<float>& tsvals)
-{
-  if (tsvals.empty()) { return 0.0; }
-  return tsvals.back();
-}
-
 void
 FrameSaver::configure(const WireCell::Configuration& cfg)
 {
@@ -105,7 +201,30 @@ FrameSaver::configure(const WireCell::Configuration& cfg)
   if (anode_tn.empty()) { THROW(ValueError() << errmsg{"FrameSaver requires an anode plane"}); }
 
   WireCell::IAnodePlane::pointer anode = Factory::find_tn<IAnodePlane>(anode_tn);
-  for (auto chid : anode->channels()) {
+  // Output is in order of increasing channel ID.
+  m_channels = anode->channels();
+  std::sort(m_channels.begin(), m_channels.end());
+  m_channels.erase(std::unique(m_channels.begin(), m_channels.end()), m_channels.end());
+  m_views.clear();
+  m_chslot.clear();
+
+  auto jthresh = cfg["zs_threshold"];
+  if (jthresh.isArray() and jthresh.size() != 3) {
+    THROW(ValueError() << errmsg{"FrameSaver: zs_threshold needs one value per plane"});
+  }
+  auto zs_plane_threshold = [&](WireCell::WirePlaneLayer_t layer) -> float {
+    if (jthresh.isNull()) { return 0.0; }
+    if (!jthresh.isArray()) { return jthresh.asFloat(); }
+    switch (layer) {
+    case WireCell::kUlayer: return jthresh[0].asFloat();
+    case WireCell::kVlayer: return jthresh[1].asFloat();
+    case WireCell::kWlayer: return jthresh[2].asFloat();
+    default: return 0.0;
+    }
+  };
+  m_zs_threshold.clear();
+  for (size_t slot = 0; slot < m_channels.size(); ++slot) {
+    const int chid = m_channels[slot];
     // geo::kU, geo::kV, geo::kW
     auto wpid = anode->resolve(chid);
     geo::View_t view;
@@ -115,17 +234,124 @@ FrameSaver::configure(const WireCell::Configuration& cfg)
     case WireCell::kWlayer: view = geo::kW; break;
     default: view = geo::kUnknown;
     }
-    m_chview[chid] = view;
+    m_views.push_back(view);
+    m_zs_threshold.push_back(zs_plane_threshold(wpid.layer()));
+    ChannelBuckets::set_slot(m_chslot, chid, slot);
   }
 
   m_digitize = get(cfg, "digitize", false);
   m_sparse = get(cfg, "sparse", true);
 
+  const std::string cooked_format = get<std::string>(cfg, "cooked_format", "wire");
+  if (cooked_format == "wire") { m_quantized = false; }
+  else if (cooked_format == "quantized") {
+    m_quantized = true;
+  }
+  else {
+    THROW(ValueError() << errmsg{"FrameSaver: unknown cooked_format: " + cooked_format});
+  }
+  m_quantize_step = get(cfg, "quantize_step", 0.1);
+  if (m_quantize_step <= 0) {
+    THROW(ValueError() << errmsg{"FrameSaver: quantize_step must be positive"});
+  }
+
+  m_assn_instances.clear();
+  m_assn_tags.clear();
+  auto jinsts = cfg["assn_raw_instances"];
+  for (const auto& ftag : jinsts.getMemberNames()) {
+    m_assn_instances[ftag] = jinsts[ftag].asString();
+  }
+  auto jatags = cfg["assn_raw_tags"];
+  for (const auto& ftag : jatags.getMemberNames()) {
+    m_assn_tags[ftag] = art::InputTag(jatags[ftag].asString());
+  }
+  if ((m_assn_instances.size() or m_assn_tags.size()) and (m_digitize or m_quantized)) {
+    THROW(ValueError() << errmsg{"FrameSaver: RawDigit assns require recob::Wire output"});
+  }
+  m_raw_saver = nullptr;
+  if (m_assn_instances.size()) {
+    const std::string saver_tn = get<std::string>(cfg, "assn_raw_saver", "");
+    if (saver_tn.empty()) {
+      THROW(ValueError() << errmsg{"FrameSaver: assn_raw_instances require assn_raw_saver"});
+    }
+    auto saver = Factory::find_tn<IArtEventVisitor>(saver_tn);
+    m_raw_saver = std::dynamic_pointer_cast<FrameSaver>(saver);
+    if (!m_raw_saver) {
+      THROW(ValueError() << errmsg{"FrameSaver: assn_raw_saver is not a FrameSaver: " + saver_tn});
+    }
+  }
+
+  auto jpad = cfg["zs_pad"];
+  if (jpad.isArray()) {
+    if (jpad.size() != 2) {
+      THROW(ValueError() << errmsg{"FrameSaver: zs_pad needs a number or [pre, post]"});
+    }
+    m_zs_pre = jpad[0].asUInt();
+    m_zs_post = jpad[1].asUInt();
+  }
+  else {
+    m_zs_pre = m_zs_post = jpad.isNull() ? 0 : jpad.asUInt();
+  }
+  m_zs_min_length = get(cfg, "zs_min_length", 0);
+  m_zs_summary = get<std::string>(cfg, "zs_summary", "");
+  m_zs_summary_scale = get(cfg, "zs_summary_scale", 1.0);
+  m_zs = m_zs_pre or m_zs_post or m_zs_min_length or !m_zs_summary.empty() or
+         std::any_of(m_zs_threshold.begin(), m_zs_threshold.end(), [](float t) { return t != 0; });
+  if (m_zs and !m_sparse) {
+    std::cerr << "wclsFrameSaver: zs_* options apply only to sparse output and are ignored\n";
+    m_zs = false;
+  }
+
   m_cmms = cfg["chanmaskmaps"];
+  const std::string cmm_format = get<std::string>(cfg, "cmm_format", "legacy");
+  m_cmm_legacy = cmm_format == "legacy" or cmm_format == "both";
+  m_cmm_compact = cmm_format == "compact" or cmm_format == "both";
+  if (!(m_cmm_legacy or m_cmm_compact)) {
+    THROW(ValueError() << errmsg{"FrameSaver: unknown cmm_format: " + cmm_format});
+  }
+
+  m_npz_prefix = get<std::string>(cfg, "npz_prefix", "");
+  m_npz_tags.clear();
+  for (auto jtag : cfg["npz_tags"]) {
+    m_npz_tags.push_back(jtag.asString());
+  }
 
   m_pedestal_mean = cfg["pedestal_mean"];
   m_pedestal_sigma = get(cfg, "pedestal_sigma", 0.0);
 
+  const std::string rounding = get<std::string>(cfg, "digitize_rounding", "round");
+  if (rounding == "round") { m_digitize_params.rounding = Digitize::kRound; }
+  else if (rounding == "truncate") {
+    m_digitize_params.rounding = Digitize::kTruncate;
+  }
+  else {
+    THROW(ValueError() << errmsg{"FrameSaver: unknown digitize_rounding: " + rounding});
+  }
+  const int adc_min = get(cfg, "adc_min", -32768);
+  const int adc_max = get(cfg, "adc_max", 32767);
+  if (adc_min < -32768 or adc_max > 32767 or adc_min > adc_max) {
+    THROW(ValueError() << errmsg{"FrameSaver: bad ADC range"});
+  }
+  m_digitize_params.adc_min = adc_min;
+  m_digitize_params.adc_max = adc_max;
+
+  const std::string compression = get<std::string>(cfg, "compression", "none");
+  if (compression == "none") { m_compression = raw::kNone; }
+  else if (compression == "huffman") {
+    m_compression = raw::kHuffman;
+  }
+  else if (compression == "zs") {
+    m_compression = raw::kZeroSuppression;
+  }
+  else if (compression == "zs_huffman") {
+    m_compression = raw::kZeroHuffman;
+  }
+  else {
+    THROW(ValueError() << errmsg{"FrameSaver: unknown compression: " + compression});
+  }
+  m_compress_threshold = get(cfg, "compress_threshold", 5);
+  m_compress_nearest_neighbor = get(cfg, "compress_nearest_neighbor", 4);
+
   if (!cfg["frame_scale"].isNull()) {
     m_frame_scale.clear();
     auto jscale = cfg["frame_scale"];
@@ -173,9 +399,24 @@ FrameSaver::configure(const WireCell::Configuration& cfg)
       m_summary_tags.push_back(tag);
       m_summary_scale.push_back(scale);
       auto so = get<std::string>(jso, tag, "sum");
-      if (so == "set") { m_summary_operators[tag] = summary_set; }
+      if (so == "sum") { m_summary_operators[tag] = kSummarySum; }
+      else if (so == "set") {
+        m_summary_operators[tag] = kSummarySet;
+      }
+      else if (so == "min") {
+        m_summary_operators[tag] = kSummaryMin;
+      }
+      else if (so == "max") {
+        m_summary_operators[tag] = kSummaryMax;
+      }
+      else if (so == "mean") {
+        m_summary_operators[tag] = kSummaryMean;
+      }
+      else if (so == "count") {
+        m_summary_operators[tag] = kSummaryCount;
+      }
       else {
-        m_summary_operators[tag] = summary_sum;
+        THROW(ValueError() << errmsg{"FrameSaver: unknown summary_operator: " + so});
       }
     }
   }
@@ -185,9 +426,19 @@ void
 FrameSaver::produces(art::ProducesCollector& collector)
 {
   for (auto tag : m_frame_tags) {
-    if (!m_digitize) {
+    if (!m_digitize and m_quantized) {
+      std::cerr << "wclsFrameSaver: promising to produce wcls::QuantizedWires named \"" << tag
+                << "\"\n";
+      collector.produces<std::vector<QuantizedWire>>(tag);
+    }
+    else if (!m_digitize) {
       std::cerr << "wclsFrameSaver: promising to produce recob::Wires named \"" << tag << "\"\n";
       collector.produces<std::vector<recob::Wire>>(tag);
+      if (m_assn_instances.count(tag) or m_assn_tags.count(tag)) {
+        std::cerr << "wclsFrameSaver: promising to produce RawDigit-Wire assns named \"" << tag
+                  << "\"\n";
+        collector.produces<raw_wire_assns>(tag);
+      }
     }
     else {
       std::cerr << "wclsFrameSaver: promising to produce raw::RawDigits named \"" << tag << "\"\n";
@@ -202,8 +453,11 @@ FrameSaver::produces(art::ProducesCollector& collector)
     const std::string cmm_name = cmm.asString();
     std::cerr << "wclsFrameSaver: promising to produce channel masks named \"" << cmm_name
               << "\"\n";
-    collector.produces<channel_list>(cmm_name + "channels");
-    collector.produces<channel_masks>(cmm_name + "masks");
+    if (m_cmm_legacy) {
+      collector.produces<channel_list>(cmm_name + "channels");
+      collector.produces<channel_masks>(cmm_name + "masks");
+    }
+    if (m_cmm_compact) { collector.produces<ChannelMasks>(cmm_name); }
   }
 }
 
@@ -220,19 +474,76 @@ tagged_traces(IFrame::pointer frame, std::string tag, ITrace::vector& ret)
   }
   auto ftags = frame->frame_tags();
   if (std::find(ftags.begin(), ftags.end(), tag) == ftags.end()) { return; }
-  ret.insert(ret.begin(), all_traces->begin(), all_traces->end());
+  ret.insert(ret.end(), all_traces->begin(), all_traces->end());
 }
 
-typedef std::unordered_map<int, ITrace::vector> traces_bychan_t;
+// A trace moved later by some ticks, sharing the samples of another.
+class ShiftedTrace : public ITrace {
+  ITrace::pointer m_trace;
+  int m_shift;
+
+public:
+  ShiftedTrace(ITrace::pointer trace, int shift) : m_trace(trace), m_shift(shift) {}
+
+  virtual int
+  channel() const
+  {
+    return m_trace->channel();
+  }
+  virtual int
+  tbin() const
+  {
+    return m_trace->tbin() + m_shift;
+  }
+  virtual const ChargeSequence&
+  charge() const
+  {
+    return m_trace->charge();
+  }
+};
+
+// The time of the earliest of the queued frames.
+static double
+earliest_time(const std::vector<IFrame::pointer>& frames)
+{
+  double ret = frames.front()->time();
+  for (const auto& frame : frames) {
+    ret = std::min(ret, frame->time());
+  }
+  return ret;
+}
+
+// Collect tagged traces across all queued frames.  Each trace's tbin
+// is made relative to the earliest frame.  The frames share one tick.
 static void
-traces_bychan(ITrace::vector& traces, traces_bychan_t& ret)
+tagged_traces(const std::vector<IFrame::pointer>& frames, std::string tag, ITrace::vector& ret)
 {
-  for (auto trace : traces) {
-    int chid = trace->channel();
-    ret[chid].push_back(trace);
+  const double time0 = earliest_time(frames);
+  for (const auto& frame : frames) {
+    const int shift = std::lround((frame->time() - time0) / frame->tick());
+    if (!shift) {
+      tagged_traces(frame, tag, ret);
+      continue;
+    }
+    ITrace::vector traces;
+    tagged_traces(frame, tag, traces);
+    for (const auto& trace : traces) {
+      ret.push_back(std::make_shared<ShiftedTrace>(trace, shift));
+    }
   }
 }
 
+// The number of ticks spanned by the traces.
+static int
+span_ticks(const ITrace::vector& traces)
+{
+  int nticks = 0;
+  for (const auto& trace : traces) {
+    nticks = std::max<int>(nticks, trace->tbin() + trace->charge().size());
+  }
+  return nticks;
+}
+
 // Issolate some silly legacy shenanigans to keep the rest of the code
 // blissfully ignorant of the evilness this implies.
 struct PU {
@@ -253,6 +564,32 @@ struct PU {
   }
 };
 
+bool
+FrameSaver::npz_wants(const std::string& ftag) const
+{
+  if (!m_npz) { return false; }
+  if (m_npz_tags.empty()) { return true; }
+  return std::find(m_npz_tags.begin(), m_npz_tags.end(), ftag) != m_npz_tags.end();
+}
+
+void
+FrameSaver::npz_frame(const std::string& ftag, size_t nticks, const npz_row_filler& fill)
+{
+  // One row at a time so no dense frame is held in memory.
+  const size_t nchans = m_channels.size();
+  std::vector<float> row(nticks);
+  m_npz->begin_array("frame_" + ftag, NpzWriter::descr<float>(), {nchans, nticks});
+  for (size_t slot = 0; slot < nchans; ++slot) {
+    std::fill(row.begin(), row.end(), 0.0);
+    fill(slot, row.data(), nticks);
+    m_npz->write(row.data(), nticks * sizeof(float));
+  }
+  m_npz->end_array();
+  m_npz->add("channels_" + ftag, m_channels, {nchans});
+  const double tick = m_frames.front()->tick();
+  m_npz->add("tickinfo_" + ftag, std::vector<double>{earliest_time(m_frames), tick}, {2});
+}
+
 void
 FrameSaver::save_as_raw(art::Event& event)
 {
@@ -263,56 +600,126 @@ FrameSaver::save_as_raw(art::Event& event)
     nticks_want = detProp.NumberTimeSamples();
   }
 
-  size_t nftags = m_frame_tags.size();
-  for (size_t iftag = 0; iftag < nftags; ++iftag) {
-    std::string ftag = m_frame_tags[iftag];
-    std::cerr << "wclsFrameSaver: saving raw::RawDigits tagged \"" << ftag << "\"\n";
+  const size_t nchans = m_channels.size();
 
-    double scale = m_frame_scale[iftag];
+  // Services are only touched from this thread.
+  const bool native = m_pedestal_mean.asString() == "native";
+  std::vector<float> pedestals(nchans, 0.0);
+  if (!native) {
+    PU pu(m_pedestal_mean);
+    for (size_t slot = 0; slot < nchans; ++slot) {
+      pedestals[slot] = pu(m_channels[slot]);
+    }
+  }
+
+  // Tags and, within a tag, channels are assembled in parallel into
+  // preallocated slots.  Only the put into the event is serial.
+  const size_t nftags = m_frame_tags.size();
+  std::vector<std::unique_ptr<std::vector<raw::RawDigit>>> outs(nftags);
+  // Ticks of the side output, if wanted.
+  std::vector<size_t> npz_nticks(nftags, 0);
+  tbb::parallel_for(size_t(0), nftags, [&](size_t iftag) {
+    const double scale = m_frame_scale[iftag];
 
     ITrace::vector traces;
-    tagged_traces(m_frame, ftag, traces);
-    traces_bychan_t bychan;
-    traces_bychan(traces, bychan);
-
-    std::unique_ptr<std::vector<raw::RawDigit>> out(new std::vector<raw::RawDigit>);
-
-    for (auto chv : m_chview) {
-      const int chid = chv.first;
-      const auto& traces = bychan[chid];
-      const size_t ntraces = traces.size();
-
-      int tbin = 0;
-      std::vector<float> charge;
-      if (ntraces) {
-        auto trace = traces[0];
-        tbin = trace->tbin();
-        charge = trace->charge();
+    tagged_traces(m_frames, m_frame_tags[iftag], traces);
+    ChannelBuckets::buckets_t bychan;
+    ChannelBuckets::bucket_by_slot(traces, m_chslot, nchans, bychan);
+
+    if (npz_wants(m_frame_tags[iftag])) {
+      npz_nticks[iftag] = nticks_want ? nticks_want : span_ticks(traces);
+    }
+
+    outs[iftag].reset(new std::vector<raw::RawDigit>(nchans));
+    auto& out = *outs[iftag];
+
+    tbb::parallel_for(size_t(0), nchans, [&](size_t slot) {
+      const int chid = m_channels[slot];
+
+      // Enforce number of ticks if we are so configured, else
+      // span all traces of the channel.
+      int nticks = nticks_want;
+      if (!nticks) {
+        for (size_t ind = bychan.offset[slot]; ind < bychan.offset[slot + 1]; ++ind) {
+          const auto& trace = traces[bychan.index[ind]];
+          nticks = std::max<int>(nticks, trace->tbin() + trace->charge().size());
+        }
       }
-      // charge may be empty here
-
-      // enforce number of ticks if we are so configured.
-      size_t ncharge = charge.size();
-      int nticks = tbin + ncharge;
-      if (nticks_want) { // force output waveform size
-        if (nticks_want < nticks) { ncharge = nticks_want - tbin; }
-        nticks = nticks_want;
+
+      // Sum all traces of the channel, then digitize once.
+      std::vector<float> wave(nticks, 0.0);
+      for (size_t ind = bychan.offset[slot]; ind < bychan.offset[slot + 1]; ++ind) {
+        const auto& trace = traces[bychan.index[ind]];
+        const auto& charge = trace->charge();
+        Digitize::accumulate(wave, trace->tbin(), charge.data(), charge.size());
       }
       raw::RawDigit::ADCvector_t adcv(nticks);
-      for (size_t ind = 0; ind < ncharge; ++ind) {
-        adcv[tbin + ind] = scale * charge[ind]; // scale + truncate/redigitize
-      }
-      out->emplace_back(raw::RawDigit(chid, nticks, adcv, raw::kNone));
-      if (m_pedestal_mean.asString() == "native") {
-        short baseline = Waveform::most_frequent(adcv);
-        out->back().SetPedestal(baseline, m_pedestal_sigma);
-      }
-      else {
-        PU pu(m_pedestal_mean);
-        out->back().SetPedestal(pu(chid), m_pedestal_sigma);
+      Digitize::Params params = m_digitize_params;
+      params.scale = scale;
+      Digitize::digitize(wave.data(), nticks, adcv.data(), params);
+      const float pedestal = native ? AdcStats::mode(adcv) : pedestals[slot];
+      if (m_compression != raw::kNone) {
+        // raw::Compress() takes these by reference.
+        unsigned int zsthresh = m_compress_threshold;
+        int nearest = m_compress_nearest_neighbor;
+        raw::Compress(adcv, m_compression, zsthresh, std::lround(pedestal), nearest);
       }
+      out[slot] = raw::RawDigit(chid, nticks, std::move(adcv), m_compression);
+      out[slot].SetPedestal(pedestal, m_pedestal_sigma);
+    });
+  });
+
+  for (size_t iftag = 0; iftag < nftags; ++iftag) {
+    const std::string& ftag = m_frame_tags[iftag];
+    std::cerr << "wclsFrameSaver: saving raw::RawDigits tagged \"" << ftag << "\"\n";
+    if (npz_wants(ftag)) {
+      const auto& out = *outs[iftag];
+      raw::RawDigit::ADCvector_t buffer;
+      npz_frame(ftag, npz_nticks[iftag], [&](size_t slot, float* row, size_t nrow) {
+        const auto& adcv = RawAdcs::samples(out[slot], buffer);
+        std::copy(adcv.begin(), adcv.begin() + std::min(nrow, adcv.size()), row);
+      });
+    }
+    event.put(std::move(outs[iftag]), ftag);
+  }
+  m_raw_event = event.id();
+  m_raw_empty = false;
+}
+
+bool
+FrameSaver::put_raw_channels(const art::EventID& id,
+                             const std::string& ftag,
+                             std::vector<int>& channels) const
+{
+  if (!m_digitize or id != m_raw_event) { return false; }
+  if (std::find(m_frame_tags.begin(), m_frame_tags.end(), ftag) == m_frame_tags.end()) {
+    return false;
+  }
+  channels.clear();
+  if (!m_raw_empty) { channels = m_channels; }
+  return true;
+}
+
+void
+FrameSaver::zs_thresholds(std::vector<float>& ret) const
+{
+  ret = m_zs_threshold;
+  if (m_zs_summary.empty()) { return; }
+
+  // The summary values are synced with the traces of the same tag.
+  std::vector<bool> seen(ret.size(), false);
+  for (const auto& frame : m_frames) {
+    const auto& summary = frame->trace_summary(m_zs_summary);
+    ITrace::vector traces;
+    tagged_traces(frame, m_zs_summary, traces);
+    const size_t ntraces = std::min(traces.size(), summary.size());
+    for (size_t ind = 0; ind < ntraces; ++ind) {
+      const int slot = ChannelBuckets::slot_of(m_chslot, traces[ind]->channel());
+      if (slot < 0) { continue; }
+      const float thresh = m_zs_summary_scale * summary[ind];
+      if (!seen[slot] or thresh > ret[slot]) { ret[slot] = thresh; }
+      seen[slot] = true;
     }
-    event.put(std::move(out), ftag);
   }
 }
 
@@ -327,88 +734,205 @@ FrameSaver::save_as_cooked(art::Event& event)
     std::cerr << "wclsFrameSaver saving cooked to " << nticks_want << " ticks\n";
   }
 
-  size_t nftags = m_frame_tags.size();
-  for (size_t iftag = 0; iftag < nftags; ++iftag) {
-    std::string ftag = m_frame_tags[iftag];
-
-    double scale = m_frame_scale[iftag];
+  const size_t nchans = m_channels.size();
+
+  // Per channel thresholds, if zero suppressing.
+  std::vector<float> zs_threshold;
+  if (m_zs) { zs_thresholds(zs_threshold); }
+
+  // Tags and, within a tag, channels are assembled in parallel into
+  // preallocated slots.  Only the put into the event is serial.
+  const size_t nftags = m_frame_tags.size();
+  std::vector<std::unique_ptr<std::vector<recob::Wire>>> outs(nftags);
+  std::vector<std::unique_ptr<std::vector<QuantizedWire>>> qouts(nftags);
+  // Ticks of the side output, if wanted.
+  std::vector<size_t> npz_nticks(nftags, 0);
+  std::vector<size_t> ntraces(nftags, 0);
+  std::vector<double> total_charge(nftags, 0.0);
+  std::vector<int> total_samples(nftags, 0);
+  tbb::parallel_for(size_t(0), nftags, [&](size_t iftag) {
+    const double scale = m_frame_scale[iftag];
 
     ITrace::vector traces;
-    tagged_traces(m_frame, ftag, traces);
-    if (traces.empty()) {
-      std::cerr << "wclsFrameSaver: no traces tagged \"" << ftag << "\"\n";
-      // fall through loop so we put (empty) outwires
+    tagged_traces(m_frames, m_frame_tags[iftag], traces);
+    ntraces[iftag] = traces.size();
+
+    ChannelBuckets::buckets_t bychan;
+    ChannelBuckets::bucket_by_slot(traces, m_chslot, nchans, bychan);
+
+    if (npz_wants(m_frame_tags[iftag])) {
+      npz_nticks[iftag] = nticks_want ? nticks_want : span_ticks(traces);
     }
+
+    // Only one of the two is filled, as per the cooked format.
+    if (m_quantized) { qouts[iftag].reset(new std::vector<QuantizedWire>(nchans)); }
     else {
-      std::cerr << "wclsFrameSaver: saving " << traces.size() << " traces tagged \"" << ftag
-                << "\"\n";
+      outs[iftag].reset(new std::vector<recob::Wire>(nchans));
     }
 
-    traces_bychan_t bychan;
-    traces_bychan(traces, bychan);
+    std::vector<double> chan_charge(nchans, 0.0);
+    std::vector<int> chan_samples(nchans, 0);
 
-    std::unique_ptr<std::vector<recob::Wire>> outwires(new std::vector<recob::Wire>);
-
-    double total_charge = 0.0;
-    int total_samples = 0;
-
-    for (auto chv : m_chview) {
-      const int chid = chv.first;
-      const auto& traces = bychan[chid];
+    tbb::parallel_for(size_t(0), nchans, [&](size_t slot) {
+      const int chid = m_channels[slot];
 
       recob::Wire::RegionsOfInterest_t rois(nticks_want);
 
-      for (const auto& trace : traces) {
+      Sparsify::Threshold zs;
+      if (m_zs) {
+        zs.threshold = zs_threshold[slot];
+        zs.pre = m_zs_pre;
+        zs.post = m_zs_post;
+        zs.min_length = m_zs_min_length;
+      }
+
+      for (size_t ind = bychan.offset[slot]; ind < bychan.offset[slot + 1]; ++ind) {
+        const auto& trace = traces[bychan.index[ind]];
         const int tbin = trace->tbin();
         const auto& charge = trace->charge();
 
-        auto beg = charge.begin();
-        const auto first = beg;
-        auto end = charge.end();
+        size_t ncharge = charge.size();
         if (nticks_want) { // user set waveform size
-          if (tbin >= nticks_want) { beg = end; }
+          if (tbin >= nticks_want) { ncharge = 0; }
           else {
             int backup = tbin + charge.size() - nticks_want;
-            if (backup > 0) { end -= backup; }
+            if (backup > 0) { ncharge -= backup; }
           }
         }
-        if (beg >= end) {
+        if (!ncharge) {
           std::cerr << "wclsFrameSaver: no samples within desired window for channel " << chid
                     << "\n";
           continue;
         }
         if (!m_sparse) {
-          std::vector<float> scaled(beg, end);
-          for (size_t i = 0; i < scaled.size(); ++i)
-            scaled[i] *= scale;
           // prefer combine_range() but it segfaults.
-          rois.add_range(tbin, scaled.begin(), scaled.end());
+          Sparsify::add_scaled(rois, tbin, charge.data(), 0, ncharge, scale);
           continue;
         }
         // sparsify trace whether or not it may itself already
         // represents a sparse ROI
-        while (true) {
-          beg = std::find_if(beg, end, [](float v) { return v != 0.0; });
-          if (beg == end) { break; }
-          auto mid = std::find_if(beg, end, [](float v) { return v == 0.0; });
-          std::vector<float> scaled(beg, mid);
-          for (int ind = 0; ind < mid - beg; ++ind) {
-            scaled[ind] *= scale;
-            total_charge += scaled[ind];
-            ++total_samples;
-          }
-          rois.add_range(tbin + beg - first, scaled.begin(), scaled.end());
-          beg = mid;
+        if (m_zs) {
+          chan_samples[slot] += Sparsify::add_threshold_runs(
+            rois, tbin, charge.data(), ncharge, zs, scale, &chan_charge[slot]);
+          continue;
         }
+        chan_samples[slot] += Sparsify::add_nonzero_runs(
+          rois, tbin, charge.data(), ncharge, scale, &chan_charge[slot]);
       }
 
-      const geo::View_t view = chv.second;
-      outwires->emplace_back(recob::Wire(rois, chid, view));
+      const geo::View_t view = m_views[slot];
+      if (m_quantized) {
+        (*qouts[iftag])[slot] = QuantizedWire(rois, chid, view, m_quantize_step);
+      }
+      else {
+        (*outs[iftag])[slot] = recob::Wire(rois, chid, view);
+      }
+    });
+
+    total_charge[iftag] = std::accumulate(chan_charge.begin(), chan_charge.end(), 0.0);
+    total_samples[iftag] = std::accumulate(chan_samples.begin(), chan_samples.end(), 0);
+  }); // loop over tags
+
+  for (size_t iftag = 0; iftag < nftags; ++iftag) {
+    const std::string& ftag = m_frame_tags[iftag];
+    if (ntraces[iftag] == 0) {
+      std::cerr << "wclsFrameSaver: no traces tagged \"" << ftag << "\"\n";
+      // we still put (empty) outwires
+    }
+    else {
+      std::cerr << "wclsFrameSaver: saving " << ntraces[iftag] << " traces tagged \"" << ftag
+                << "\"\n";
+    }
+    std::cerr << "FrameSaver: q=" << total_charge[iftag] << " n=" << total_samples[iftag]
+              << " tag=" << ftag << "\n";
+    if (npz_wants(ftag) and m_quantized) {
+      const auto& out = *qouts[iftag];
+      npz_frame(ftag, npz_nticks[iftag], [&](size_t slot, float* row, size_t nrow) {
+        for (const auto& roi : out[slot].ROIs()) {
+          const size_t beg = roi.begin_index();
+          const size_t end = std::min(roi.end_index(), nrow);
+          for (size_t ind = beg; ind < end; ++ind) {
+            row[ind] = roi[ind - beg];
+          }
+        }
+      });
+    }
+    else if (npz_wants(ftag)) {
+      const auto& out = *outs[iftag];
+      npz_frame(ftag, npz_nticks[iftag], [&](size_t slot, float* row, size_t nrow) {
+        for (const auto& range : out[slot].SignalROI().get_ranges()) {
+          const size_t beg = range.begin_index();
+          if (beg >= nrow) { continue; }
+          const size_t end = std::min<size_t>(range.end_index(), nrow);
+          std::copy(range.begin(), range.begin() + (end - beg), row + beg);
+        }
+      });
+    }
+    if (m_quantized) { event.put(std::move(qouts[iftag]), ftag); }
+    else {
+      event.put(std::move(outs[iftag]), ftag);
+      save_assns(event, ftag);
+    }
+  }
+}
+
+void
+FrameSaver::save_assns(art::Event& event, const std::string& ftag)
+{
+  const size_t nchans = m_channels.size();
+
+  // Index of the RawDigit of each channel slot, -1 if none.
+  std::vector<long> rawind(nchans, -1);
+  art::Handle<std::vector<raw::RawDigit>> rawh;
+  auto inst = m_assn_instances.find(ftag);
+  auto atag = m_assn_tags.find(ftag);
+  if (inst != m_assn_instances.end()) {
+    // The sibling's Ptrs are made by index so its collection must
+    // hold exactly our channels in our order.
+    std::vector<int> sibling;
+    if (!m_raw_saver->put_raw_channels(event.id(), inst->second, sibling)) {
+      THROW(RuntimeError() << errmsg{"wclsFrameSaver: assn_raw_saver put no raw::RawDigits "
+                                     "named \"" + inst->second + "\" before \"" + ftag + "\""});
+    }
+    if (sibling != m_channels) {
+      THROW(RuntimeError() << errmsg{"wclsFrameSaver: raw::RawDigits named \"" + inst->second +
+                                     "\" do not match the channels of \"" + ftag + "\""});
+    }
+    std::iota(rawind.begin(), rawind.end(), 0);
+  }
+  else if (atag != m_assn_tags.end()) {
+    if (!event.getByLabel(atag->second, rawh)) {
+      std::string msg = "wclsFrameSaver: failed to get vector<raw::RawDigit>: " +
+                        atag->second.encode();
+      THROW(RuntimeError() << errmsg{msg});
+    }
+    for (size_t ind = 0; ind < rawh->size(); ++ind) {
+      const int slot = ChannelBuckets::slot_of(m_chslot, (*rawh)[ind].Channel());
+      if (slot < 0) { continue; }
+      rawind[slot] = ind;
+    }
+  }
+  else {
+    return;
+  }
+
+  auto assns = std::make_unique<raw_wire_assns>();
+  art::PtrMaker<recob::Wire> wire_ptr(event, ftag);
+  if (rawh.isValid()) {
+    for (size_t slot = 0; slot < nchans; ++slot) {
+      if (rawind[slot] < 0) { continue; }
+      assns->addSingle(art::Ptr<raw::RawDigit>(rawh, rawind[slot]), wire_ptr(slot));
+    }
+  }
+  else {
+    art::PtrMaker<raw::RawDigit> raw_ptr(event, inst->second);
+    for (size_t slot = 0; slot < nchans; ++slot) {
+      assns->addSingle(raw_ptr(rawind[slot]), wire_ptr(slot));
     }
-    std::cerr << "FrameSaver: q=" << total_charge << " n=" << total_samples << " tag=" << ftag
-              << "\n";
-    event.put(std::move(outwires), ftag);
-  } // loop over tags
+  }
+  std::cerr << "wclsFrameSaver: saving " << assns->size() << " RawDigit-Wire assns tagged \""
+            << ftag << "\"\n";
+  event.put(std::move(assns), ftag);
 }
 
 void
@@ -419,42 +943,59 @@ FrameSaver::save_summaries(art::Event& event)
     return; // no tags
   }
 
-  const size_t nchans = m_chview.size();
+  const size_t nchans = m_channels.size();
 
-  // for each summary
-  for (int tag_ind = 0; tag_ind < ntags; ++tag_ind) {
+  // for each summary, in parallel
+  std::vector<std::unique_ptr<std::vector<double>>> outs(ntags);
+  tbb::parallel_for(0, ntags, [&](int tag_ind) {
     // The scale set for the tag.
     const double scale = m_summary_scale[tag_ind];
+    const auto tag = m_summary_tags[tag_ind];
+    const auto oper = m_summary_operators.at(tag);
 
-    std::unique_ptr<std::vector<double>> outsum(new std::vector<double>(nchans, 0.0));
+    outs[tag_ind].reset(new std::vector<double>(nchans, 0.0));
+    auto& outsum = *outs[tag_ind];
+    std::vector<int> counts(nchans, 0);
 
     // The "summary" and "traces" vectors of the same tag are
     // synced, element-by-element.  Each element corresponds to
     // one trace (ROI).  No particular order or correlation by
-    // channel exists, and that's what the rest of this code
-    // creates.
-    auto tag = m_summary_tags[tag_ind];
-    const auto& summary = m_frame->trace_summary(tag);
-    ITrace::vector traces;
-    tagged_traces(m_frame, tag, traces);
-    const size_t ntraces = traces.size();
-
-    std::unordered_map<int, std::vector<float>> bychan;
-    for (size_t itrace = 0; itrace < ntraces; ++itrace) {
-      const int chid = traces[itrace]->channel();
-      const double summary_value = summary[itrace];
-      bychan[chid].push_back(summary_value);
+    // channel exists so each value is folded into its channel's
+    // output element as it is met.
+    for (const auto& frame : m_frames) {
+      const auto& summary = frame->trace_summary(tag);
+      ITrace::vector traces;
+      tagged_traces(frame, tag, traces);
+      const size_t ntraces = std::min(traces.size(), summary.size());
+      for (size_t ind = 0; ind < ntraces; ++ind) {
+        const int slot = ChannelBuckets::slot_of(m_chslot, traces[ind]->channel());
+        if (slot < 0) { continue; }
+        const double val = summary[ind];
+        double& out = outsum[slot];
+        const bool first = counts[slot]++ == 0;
+        switch (oper) {
+        case kSummarySum:
+        case kSummaryMean: out += val; break;
+        case kSummarySet: out = val; break;
+        case kSummaryMin: out = first ? val : std::min(out, val); break;
+        case kSummaryMax: out = first ? val : std::max(out, val); break;
+        case kSummaryCount: break;
+        }
+      }
     }
-    auto oper = m_summary_operators[tag];
 
-    size_t chanind = 0;
-    for (auto chv : m_chview) {
-      const int chid = chv.first;
-      const float val = oper(bychan[chid]);
-      outsum->at(chanind) = val * scale;
-      ++chanind;
+    for (size_t slot = 0; slot < nchans; ++slot) {
+      if (oper == kSummaryCount) { outsum[slot] = counts[slot]; }
+      else if (oper == kSummaryMean and counts[slot]) {
+        outsum[slot] /= counts[slot];
+      }
+      outsum[slot] *= scale;
     }
-    event.put(std::move(outsum), tag);
+  });
+
+  for (int tag_ind = 0; tag_ind < ntags; ++tag_ind) {
+    if (m_npz) { m_npz->add("summary_" + m_summary_tags[tag_ind], *outs[tag_ind], {nchans}); }
+    event.put(std::move(outs[tag_ind]), m_summary_tags[tag_ind]);
   }
 }
 
@@ -467,18 +1008,48 @@ FrameSaver::save_cmms(art::Event& event)
       << "wclsFrameSaver: wrong type for configuration array of channel mask maps to save\n";
     return;
   }
+  // IFrame::masks() returns a copy so get it once per frame.
+  std::vector<Waveform::ChannelMaskMap> frame_cmms;
+  for (const auto& frame : m_frames) {
+    frame_cmms.push_back(frame->masks());
+  }
+
   for (auto jcmm : m_cmms) {
     std::string name = jcmm.asString();
-    std::unique_ptr<channel_list> out_list(new channel_list);
-    std::unique_ptr<channel_masks> out_masks(new channel_masks);
 
-    auto cmm = m_frame->masks();
-    auto it = cmm.find(name);
-    if (it == cmm.end()) {
+    // The masks of this name from each frame, merged over frames
+    // only if more than one has them.
+    std::vector<const Waveform::ChannelMasks*> found;
+    for (const auto& cmm : frame_cmms) {
+      auto it = cmm.find(name);
+      if (it != cmm.end()) { found.push_back(&it->second); }
+    }
+    if (found.empty()) {
       std::cerr << "wclsFrameSaver: failed to find requested channel masks \"" << name << "\"\n";
       continue;
     }
-    for (auto cmit : it->second) { // int->vec<pair<int,int>>
+    Waveform::ChannelMasks merged;
+    const Waveform::ChannelMasks* masks = found[0];
+    if (found.size() > 1) {
+      for (const auto* cm : found) {
+        for (const auto& cmit : *cm) { // int->vec<pair<int,int>>
+          auto& ranges = merged[cmit.first];
+          ranges.insert(ranges.end(), cmit.second.begin(), cmit.second.end());
+        }
+      }
+      masks = &merged;
+    }
+    if (masks->empty()) {
+      std::cerr << "wclsFrameSaver: found empty channel masks for \"" << name << "\"\n";
+    }
+
+    if (m_cmm_compact) { event.put(std::make_unique<ChannelMasks>(*masks), name); }
+    if (!m_cmm_legacy) { continue; }
+
+    std::unique_ptr<channel_list> out_list(new channel_list);
+    std::unique_ptr<channel_masks> out_masks(new channel_masks);
+    out_list->reserve(masks->size());
+    for (const auto& cmit : *masks) {
       out_list->push_back(cmit.first);
       for (auto be : cmit.second) {
         out_masks->push_back(cmit.first);
@@ -486,10 +1057,6 @@ FrameSaver::save_cmms(art::Event& event)
         out_masks->push_back(be.second);
       }
     }
-
-    if (out_list->empty()) {
-      std::cerr << "wclsFrameSaver: found empty channel masks for \"" << name << "\"\n";
-    }
     event.put(std::move(out_list), name + "channels");
     event.put(std::move(out_masks), name + "masks");
   }
@@ -505,10 +1072,19 @@ FrameSaver::save_empty(art::Event& event)
     if (m_digitize) {
       std::unique_ptr<std::vector<raw::RawDigit>> out(new std::vector<raw::RawDigit>);
       event.put(std::move(out), ftag);
+      m_raw_event = event.id();
+      m_raw_empty = true;
+    }
+    else if (m_quantized) {
+      std::unique_ptr<std::vector<QuantizedWire>> outwires(new std::vector<QuantizedWire>);
+      event.put(std::move(outwires), ftag);
     }
     else {
       std::unique_ptr<std::vector<recob::Wire>> outwires(new std::vector<recob::Wire>);
       event.put(std::move(outwires), ftag);
+      if (m_assn_instances.count(ftag) or m_assn_tags.count(ftag)) {
+        event.put(std::make_unique<raw_wire_assns>(), ftag);
+      }
     }
   }
 
@@ -519,6 +1095,8 @@ FrameSaver::save_empty(art::Event& event)
 
   for (auto jcmm : m_cmms) {
     std::string name = jcmm.asString();
+    if (m_cmm_compact) { event.put(std::make_unique<ChannelMasks>(), name); }
+    if (!m_cmm_legacy) { continue; }
     std::unique_ptr<channel_list> out_list(new channel_list);
     std::unique_ptr<channel_masks> out_masks(new channel_masks);
     event.put(std::move(out_list), name + "channels");
@@ -529,38 +1107,60 @@ FrameSaver::save_empty(art::Event& event)
 void
 FrameSaver::visit(art::Event& event)
 {
-  if (!m_frame) {
+  if (m_frames.empty()) {
     save_empty(event);
     return;
   }
+  if (m_frames.size() > 1) {
+    std::cerr << "wclsFrameSaver: merging " << m_frames.size() << " frames\n";
+  }
 
-  if (m_digitize) { save_as_raw(event); }
-  else {
-    save_as_cooked(event);
+  if (!m_npz_prefix.empty()) {
+    std::stringstream ss;
+    ss << m_npz_prefix << "_" << event.run() << "_" << event.subRun() << "_" << event.event()
+       << ".npz";
+    std::cerr << "wclsFrameSaver: writing " << ss.str() << "\n";
+    m_npz.reset(new NpzWriter(ss.str()));
   }
 
-  save_summaries(event);
+  try {
+    // Traces are merged on one tick grid.
+    for (const auto& frame : m_frames) {
+      if (frame->tick() != m_frames.front()->tick()) {
+        THROW(RuntimeError() << errmsg{"wclsFrameSaver: queued frames differ in tick"});
+      }
+    }
+
+    if (m_digitize) { save_as_raw(event); }
+    else {
+      save_as_cooked(event);
+    }
+
+    save_summaries(event);
 
-  save_cmms(event);
+    save_cmms(event);
+
+    if (m_npz) { m_npz->close(); }
+  }
+  catch (...) {
+    // Do not leave the file open for the next event.
+    m_npz.reset();
+    m_frames.clear();
+    throw;
+  }
+  m_npz.reset();
 
-  m_frame = nullptr; // done with stashed frame
+  m_frames.clear(); // done with stashed frames
 }
 
 bool
 FrameSaver::operator()(const WireCell::IFrame::pointer& inframe,
                        WireCell::IFrame::pointer& outframe)
 {
-  // set an IFrame based on last visited event.
+  // queue frames until the next visited event.
   outframe = inframe;
   if (inframe) {
-    if (m_frame) {
-      std::cerr
-        << "wclsFrameSaver: warning: dropping prior frame.  Fixme to handle queue of frames.\n";
-    }
-    // else {
-    //     std::cerr << "wclsFrameSaver got frame\n";
-    // }
-    m_frame = inframe;
+    m_frames.push_back(inframe);
   }
   // else {
   //     std::cerr << "wclsFrameSaver sees EOS\n";
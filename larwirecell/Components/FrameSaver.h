@@ -2,13 +2,24 @@
  * their content as:
 
  - waveform content as vector collections of either raw::RawDigit or
-   recob::Wire.
+   recob::Wire or, more compactly, wcls::QuantizedWire.
 
  - summaries as vector<double>
 
- - channel mask maps as vector<int> holding channel numbers
+ - channel mask maps as vector<int> holding channel numbers and/or
+   as compact wcls::ChannelMasks
+
+ - optionally, raw::RawDigit to recob::Wire associations
+
+ - optionally, a per-event NumPy .npz file with dense frames,
+   channels and summaries, for use outside of art
 
  It can be configured to scale waveform or summary values by some constant.
+
+ All frames received between two art::Event visits are queued and
+ their traces are saved together, merged by channel, as one
+ collection per tag.  Ticks count from the time of the earliest of
+ these frames, which must all have the same tick.
 */
 
 #ifndef LARWIRECELL_COMPONENTS_FRAMESAVER
@@ -17,12 +28,22 @@
 #include "WireCellIface/IFrameFilter.h"
 #include "WireCellIface/IConfigurable.h"
 #include "larcoreobj/SimpleTypesAndConstants/geo_types.h"
+#include "lardataobj/RawData/RawTypes.h"
 #include "larwirecell/Interfaces/IArtEventVisitor.h"
+#include "larwirecell/Utilities/Digitize.h"
+#include "larwirecell/Utilities/NpzWriter.h"
+
+#include "canvas/Persistency/Common/Assns.h"
+#include "canvas/Persistency/Provenance/EventID.h"
+#include "canvas/Utilities/InputTag.h"
+#include "lardataobj/RawData/RawDigit.h"
+#include "lardataobj/RecoBase/Wire.h"
 
-#include <string>
 #include <functional>
-#include <vector>
+#include <string>
 #include <map>
+#include <memory>
+#include <vector>
 #include <unordered_map>
 
 namespace wcls {
@@ -67,27 +88,83 @@ namespace wcls {
 	typedef std::vector<int> channel_list;
 	typedef std::vector<int> channel_masks;
 
+        /// Associations between the raw::RawDigit and recob::Wire
+        /// of each channel, as EventButcher makes.
+        typedef art::Assns<raw::RawDigit, recob::Wire> raw_wire_assns;
+
+        /// If this saver digitizes, get the channels, in order, of
+        /// the raw::RawDigit collection of the frame tag that it put
+        /// into the event of the given ID.  Return false if it did
+        /// not, as when that event has not been visited yet.
+        bool put_raw_channels(const art::EventID& id, const std::string& ftag,
+                              std::vector<int>& channels) const;
+
 
     private:
 
-        // ordered.
-        std::map<int, geo::View_t> m_chview;
+        // The anode channels in output order and their views,
+        // indexed by "slot", and a dense channel ID to slot lookup
+        // which is -1 for channels not in the anode.
+        std::vector<int> m_channels;
+        std::vector<geo::View_t> m_views;
+        std::vector<int> m_chslot;
 
 
-        WireCell::IFrame::pointer m_frame;
+        // frames received since the last visit
+        std::vector<WireCell::IFrame::pointer> m_frames;
 	std::vector<std::string> m_frame_tags, m_summary_tags;
 	std::vector<double> m_frame_scale, m_summary_scale;
 
-        typedef std::function<float(const std::vector<float>& tsvals)> summarizer_function;
-        std::unordered_map< std::string, summarizer_function> m_summary_operators;
+        // How per-trace summary values are combined per channel.
+        enum summary_operator_t {
+            kSummarySum, kSummarySet, kSummaryMin, kSummaryMax, kSummaryMean, kSummaryCount
+        };
+        std::unordered_map< std::string, summary_operator_t> m_summary_operators;
 
 	int m_nticks;
 	bool m_digitize, m_sparse;
+        bool m_quantized;
+        double m_quantize_step;
+
+        // RawDigit-Wire assns, by frame tag, pairing with a sibling
+        // saver's instance or with an existing collection.
+        std::map<std::string, std::string> m_assn_instances;
+        std::map<std::string, art::InputTag> m_assn_tags;
+        std::shared_ptr<FrameSaver> m_raw_saver;
+
+        // The event last given raw::RawDigits, and if they were empty.
+        art::EventID m_raw_event;
+        bool m_raw_empty;
+
+        // Threshold zero suppression.  The threshold from
+        // configuration is per slot.
+        bool m_zs;
+        std::vector<float> m_zs_threshold;
+        size_t m_zs_pre, m_zs_post, m_zs_min_length;
+        std::string m_zs_summary;
+        double m_zs_summary_scale;
+        void zs_thresholds(std::vector<float>& ret) const;
+
 	Json::Value m_cmms, m_pedestal_mean;
+        bool m_cmm_legacy, m_cmm_compact;
 	double m_pedestal_sigma;
+        Digitize::Params m_digitize_params;
+        raw::Compress_t m_compression;
+        unsigned int m_compress_threshold;
+        int m_compress_nearest_neighbor;
+
+        // Optional NumPy side output, open only during a visit.
+        std::string m_npz_prefix;
+        std::vector<std::string> m_npz_tags;
+        std::unique_ptr<NpzWriter> m_npz;
+        bool npz_wants(const std::string& ftag) const;
+        // Fill the zeroed row of nticks samples of a channel slot.
+        typedef std::function<void(size_t slot, float* row, size_t nticks)> npz_row_filler;
+        void npz_frame(const std::string& ftag, size_t nticks, const npz_row_filler& fill);
 
 	void save_as_raw(art::Event & event);
 	void save_as_cooked(art::Event & event);
+	void save_assns(art::Event & event, const std::string& ftag);
 	void save_summaries(art::Event & event);
 	void save_cmms(art::Event & event);
         void save_empty(art::Event& event);
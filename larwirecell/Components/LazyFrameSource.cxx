@@ -9,17 +9,30 @@
 #include "TTimeStamp.h"
 
 
+#include "larwirecell/Utilities/RawAdcs.h"
+
 #include "WireCellIface/IFrame.h"
 
+#include "tbb/task_group.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
 namespace wcls {
 
+    // The ADC samples stay in the art::Event until converted to
+    // float.  Compressed samples are uncompressed only then, into a
+    // temporary buffer.
     class LazyTrace : public WireCell::ITrace {
-        mutable art::Handle< std::vector<raw::RawDigit> > m_rdvh;
+        art::Handle< std::vector<raw::RawDigit> > m_rdvh;
         size_t m_index;
         int m_channel;
-        
-        mutable WireCell::ITrace::ChargeSequence m_charge;
 
+        mutable WireCell::ITrace::ChargeSequence m_charge;
+        // the conversion may be done by a prefetch task or by the
+        // consumer, whichever comes first.
+        mutable std::once_flag m_converted;
 
     public:
         LazyTrace(art::Handle< std::vector<raw::RawDigit> > rdvh, size_t index)
@@ -30,13 +43,11 @@ namespace wcls {
 	virtual int tbin() const { return 0; }
 
 	virtual const ChargeSequence& charge() const {
-            if (m_charge.empty()) {
-                auto const& rd = m_rdvh->at(m_index);
-                const raw::RawDigit::ADCvector_t& adcv = rd.ADCs();
-                //std::cerr << "trace " << m_index << " chan " << m_channel << " with " << adcv.size() << " samples\n";
-                m_charge.insert(m_charge.end(), adcv.begin(), adcv.end());
-                m_rdvh.clear(); // bye bye
-            }
+            std::call_once(m_converted, [this]() {
+                raw::RawDigit::ADCvector_t buffer;
+                const auto& adcv = RawAdcs::samples(m_rdvh->at(m_index), buffer);
+                m_charge.assign(adcv.begin(), adcv.end());
+            });
             return m_charge;
         }
 
@@ -47,6 +58,12 @@ namespace wcls {
         double m_time, m_tick;
         tag_list_t m_tags;
         WireCell::ITrace::shared_vector m_traces;
+
+        // prefetch state
+        mutable std::vector<size_t> m_order;
+        mutable std::atomic<size_t> m_next{0};
+        mutable std::atomic<bool> m_stop{false};
+        mutable tbb::task_group m_prefetch;
     public:
         LazyFrame(art::Handle< std::vector<raw::RawDigit> > rdvh,
                   int ident, double time, double tick, const tag_list_t& tags)
@@ -59,7 +76,54 @@ namespace wcls {
             m_traces = WireCell::ITrace::shared_vector(traces);
         }
 
-        virtual ~LazyFrame() { }
+        virtual ~LazyFrame() {
+            // The traces refer to art::Event data so no prefetch
+            // task may outlive the frame.
+            m_stop = true;
+            m_prefetch.wait();
+        }
+
+        // Start ntasks background tasks which materialize the traces
+        // in the order of the given channels followed by any traces
+        // of channels not listed.  Call at most once.
+        void prefetch(const std::vector<int>& chorder, int ntasks) const {
+            if (!m_order.empty()) {
+                return;
+            }
+            const size_t ntraces = m_traces->size();
+            std::unordered_map<int, size_t> chind;
+            for (size_t ind = 0; ind < ntraces; ++ind) {
+                chind[m_traces->at(ind)->channel()] = ind;
+            }
+            std::vector<bool> seen(ntraces, false);
+            m_order.reserve(ntraces);
+            for (int ch : chorder) {
+                auto it = chind.find(ch);
+                if (it == chind.end() or seen[it->second]) {
+                    continue;
+                }
+                seen[it->second] = true;
+                m_order.push_back(it->second);
+            }
+            for (size_t ind = 0; ind < ntraces; ++ind) {
+                if (!seen[ind]) {
+                    m_order.push_back(ind);
+                }
+            }
+
+            m_next = 0;
+            for (int itask = 0; itask < ntasks; ++itask) {
+                m_prefetch.run([this]() {
+                    while (!m_stop) {
+                        const size_t ind = m_next++;
+                        if (ind >= m_order.size()) {
+                            break;
+                        }
+                        m_traces->at(m_order[ind])->charge();
+                    }
+                });
+            }
+        }
 
         virtual const tag_list_t& frame_tags() const {
             return m_tags;
@@ -115,6 +179,7 @@ using namespace WireCell;
 
 LazyFrameSource::LazyFrameSource()
     : m_nticks(0)
+    , m_prefetch(0)
 {
 }
 
@@ -130,6 +195,13 @@ WireCell::Configuration LazyFrameSource::default_configuration() const
     cfg["tick"] = 0.5*WireCell::units::us;
     cfg["frame_tags"][0] = "orig"; // the tags to apply to this frame
     cfg["nticks"] = m_nticks; // if nonzero, truncate or baseline-pad frame to this number of ticks.
+    // If nonzero, this many background tasks convert the traces of
+    // an emitted frame ahead of its consumer.
+    cfg["prefetch"] = m_prefetch;
+    // Optional IChannelNoiseDatabase type:name.  If given, its
+    // coherent channel groups (eg as set with set_channel_groups())
+    // define the prefetch order.
+    cfg["noisedb"] = "";
     return cfg;
 }
 
@@ -146,6 +218,12 @@ void LazyFrameSource::configure(const WireCell::Configuration& cfg)
         m_frame_tags.push_back(jtag.asString());
     }
     m_nticks = get(cfg, "nticks", m_nticks);
+
+    m_prefetch = get(cfg, "prefetch", m_prefetch);
+    const std::string noisedb_tn = get<std::string>(cfg, "noisedb", "");
+    if (!noisedb_tn.empty()) {
+        m_noisedb = Factory::find_tn<IChannelNoiseDatabase>(noisedb_tn);
+    }
 }
 
 
@@ -188,6 +266,16 @@ bool LazyFrameSource::operator()(WireCell::IFrame::pointer& frame)
     }
     frame = m_frames.front();
     m_frames.pop_front();
+
+    if (frame and m_prefetch > 0) {
+        std::vector<int> chorder;
+        if (m_noisedb) {
+            for (const auto& group : m_noisedb->coherent_channels()) {
+                chorder.insert(chorder.end(), group.begin(), group.end());
+            }
+        }
+        std::dynamic_pointer_cast<const LazyFrame>(frame)->prefetch(chorder, m_prefetch);
+    }
     return true;
 }
 
@@ -5,6 +5,12 @@
  * int samples of the raw::RawDigit and the float samples of
  * IFrame/ITrace.  This can help memory usage if a subset of the
  * frame is processed serially.
+ *
+ * Optionally, once a frame is emitted, a number of background tasks
+ * may "prefetch" its traces, ie perform the conversion ahead of the
+ * consumer.  The prefetch order follows the coherent channel groups
+ * of a channel noise database, if one is given, so that conversion
+ * of the next group overlaps with the processing of the current one.
  */
 
 #ifndef LARWIRECELL_COMPONENTS_LAZYFRAMESOURCE
@@ -13,6 +19,7 @@
 #include "larwirecell/Interfaces/IArtEventVisitor.h"
 #include "WireCellIface/IFrameSource.h"
 #include "WireCellIface/IConfigurable.h"
+#include "WireCellIface/IChannelNoiseDatabase.h"
 
 #include "canvas/Utilities/InputTag.h"
 
@@ -45,6 +52,11 @@ namespace wcls {
 	int m_nticks;
 	std::vector<std::string> m_frame_tags;
 
+        // number of background prefetch tasks, zero disables.
+        int m_prefetch;
+        // optional source of the channel prefetch order.
+        WireCell::IChannelNoiseDatabase::pointer m_noisedb;
+
     };
 
 }
@@ -1,18 +1,28 @@
 #include "RawFrameSource.h"
+#include "ChannelMaskReader.h"
 #include "art/Framework/Principal/Handle.h"
 
 // for tick
 //#include "lardata/DetectorInfoServices/DetectorPropertiesService.h"
 #include "lardataobj/RawData/RawDigit.h"
 #include "art/Framework/Principal/Event.h"
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "larevt/CalibrationDBI/Interface/DetPedestalProvider.h"
+#include "larevt/CalibrationDBI/Interface/DetPedestalService.h"
 
 #include "TTimeStamp.h"
 
 
+#include "larwirecell/Utilities/AdcStats.h"
+#include "larwirecell/Utilities/RawAdcs.h"
+
 #include "WireCellIface/SimpleFrame.h"
 #include "WireCellIface/SimpleTrace.h"
 #include "WireCellUtil/NamedFactory.h"
 
+#include <cmath>
+#include <limits>
+
 WIRECELL_FACTORY(wclsRawFrameSource, wcls::RawFrameSource,
 		 wcls::IArtEventVisitor, WireCell::IFrameSource)
 
@@ -37,6 +47,16 @@ WireCell::Configuration RawFrameSource::default_configuration() const
     cfg["tick"] = 0.5*WireCell::units::us;
     cfg["frame_tags"][0] = "orig"; // the tags to apply to this frame
     cfg["nticks"] = m_nticks; // if nonzero, truncate or baseline-pad frame to this number of ticks.
+    // If set, subtract a per-channel pedestal while converting ADC
+    // to float.  If "service", use PedMean() from DetPedestalService,
+    // cached for a subrun.  A pedestal IOV which changes within a
+    // subrun is not followed.  If "mode", use the most
+    // frequent ADC value of the waveform.  If empty, keep raw ADC.
+    cfg["pedestal"] = "";
+    // Art tags of wcls::ChannelMasks products, as FrameSaver writes
+    // with cmm_format "compact", to give to the frame as channel
+    // mask maps named by instance (or label).
+    cfg["cmm_tags"] = Json::arrayValue;
     return cfg;
 }
 
@@ -53,6 +73,12 @@ void RawFrameSource::configure(const WireCell::Configuration& cfg)
         m_frame_tags.push_back(jtag.asString());
     }
     m_nticks = get(cfg, "nticks", m_nticks);
+
+    m_pedestal = get<std::string>(cfg, "pedestal", "");
+    if (!(m_pedestal.empty() or m_pedestal == "service" or m_pedestal == "mode")) {
+        THROW(ValueError() << errmsg{"WireCell::RawFrameSource unknown pedestal: " + m_pedestal});
+    }
+    m_cmm_tags = channel_mask_tags(cfg["cmm_tags"]);
 }
 
 
@@ -67,18 +93,26 @@ double tdiff(const art::Timestamp& ts1, const art::Timestamp& ts2)
 }
 
 
+// Every consumer of this frame converts every trace to float so, unlike
+// LazyFrameSource, there is no gain in deferring that.
 static
-SimpleTrace* make_trace(const raw::RawDigit& rd, unsigned int nticks_want)
+SimpleTrace* make_trace(const raw::RawDigit& rd, unsigned int nticks_want,
+                        bool mode_pedestal, float pedestal)
 {
     const int chid = rd.Channel();
     const int tbin = 0;
-    const raw::RawDigit::ADCvector_t& adcv = rd.ADCs();
+    raw::RawDigit::ADCvector_t buffer;
+    const raw::RawDigit::ADCvector_t& adcv = RawAdcs::samples(rd, buffer);
 
     short baseline = 0;
     unsigned int nadcs = adcv.size();
+    if (mode_pedestal) {
+        baseline = AdcStats::mode(adcv);
+        pedestal = baseline;
+    }
     if (nticks_want > 0) {      // don't want natural input size
-        if (nticks_want > nadcs) {
-            baseline = Waveform::most_frequent(adcv);
+        if (nticks_want > nadcs and !mode_pedestal) {
+            baseline = AdcStats::mode(adcv);
         }
         nadcs = std::min(nadcs, nticks_want);
     }
@@ -87,15 +121,36 @@ SimpleTrace* make_trace(const raw::RawDigit& rd, unsigned int nticks_want)
     }
 
     auto strace = new SimpleTrace(chid, tbin, nticks_want);
+    auto& charge = strace->charge();
     for (unsigned int itick=0; itick < nadcs; ++ itick) {
-	strace->charge()[itick] = adcv[itick];
+        charge[itick] = adcv[itick] - pedestal;
     }
     for (unsigned int itick = nadcs; itick < nticks_want; ++itick) {
-	strace->charge()[itick] = baseline;
+        charge[itick] = baseline - pedestal;
     }
     return strace;
 }
 
+float RawFrameSource::service_pedestal(const art::Event& event, int chid)
+{
+    if (event.id().subRunID() != m_pedestal_subrun) {
+        m_pedestals.clear();
+        m_pedestal_subrun = event.id().subRunID();
+    }
+    if (chid < 0) {
+        return 0.0;
+    }
+    const size_t ind = chid;
+    if (ind >= m_pedestals.size()) {
+        m_pedestals.resize(ind+1, std::numeric_limits<float>::quiet_NaN());
+    }
+    if (std::isnan(m_pedestals[ind])) {
+        art::ServiceHandle<lariov::DetPedestalService const> dps;
+        m_pedestals[ind] = dps->GetPedestalProvider().PedMean(chid);
+    }
+    return m_pedestals[ind];
+}
+
 void RawFrameSource::visit(art::Event & event)
 {
     // fixme: want to avoid depending on DetectorPropertiesService for now.
@@ -116,23 +171,30 @@ void RawFrameSource::visit(art::Event & event)
     WireCell::ITrace::vector traces(nchannels);
     for (size_t ind=0; ind<nchannels; ++ind) {
         auto const& rd = rdv.at(ind);
-        traces[ind] = ITrace::pointer(make_trace(rd, m_nticks));
+        float pedestal = 0.0;
+        if (m_pedestal == "service") {
+            pedestal = service_pedestal(event, rd.Channel());
+        }
+        traces[ind] = ITrace::pointer(make_trace(rd, m_nticks, m_pedestal == "mode", pedestal));
 	if (!ind) {
             if (m_nticks) {
                 std::cerr
-                    << "\tinput nticks=" << rd.ADCs().size() << " setting to " << m_nticks
+                    << "\tinput nticks=" << RawAdcs::nsamples(rd) << " setting to " << m_nticks
                     << std::endl;
             }
             else {
                 std::cerr
-                    << "\tinput nticks=" << rd.ADCs().size() << " keeping as is"
+                    << "\tinput nticks=" << RawAdcs::nsamples(rd) << " keeping as is"
                     << std::endl;
             }
 	}
     }
 
+    Waveform::ChannelMaskMap cmm;
+    read_channel_masks(event, m_cmm_tags, cmm);
+
     const double time = tdiff(event.getRun().beginTime(), event.time());
-    auto sframe = new WireCell::SimpleFrame(event.event(), time, traces, tick);
+    auto sframe = new WireCell::SimpleFrame(event.event(), time, traces, tick, cmm);
     for (auto tag : m_frame_tags) {
         //std::cerr << "\ttagged: " << tag << std::endl;
         sframe->tag_frame(tag);
@@ -3,6 +3,10 @@
  *
  * Raw means that the waveforms are taken from the art::Event as a
  * labeled std::vector<raw::RawDigit> collection.
+ *
+ * Optionally a per-channel pedestal is subtracted as the ADC samples
+ * are converted to float.  See LazyFrameSource for a source which
+ * defers that conversion.
  */
 
 #ifndef LARWIRECELL_COMPONENTS_RAWFRAMESOURCE
@@ -12,6 +16,7 @@
 #include "WireCellIface/IFrameSource.h"
 #include "WireCellIface/IConfigurable.h"
 
+#include "canvas/Persistency/Provenance/SubRunID.h"
 #include "canvas/Utilities/InputTag.h"
 
 #include <string>
@@ -42,6 +47,15 @@ namespace wcls {
         double m_tick;
 	int m_nticks;
 	std::vector<std::string> m_frame_tags;
+        std::vector<art::InputTag> m_cmm_tags;
+
+        // pedestal subtraction mode and service pedestal cache.
+        // The provider does not expose its IOV so the cache is kept
+        // for one subrun.
+        std::string m_pedestal;
+        std::vector<float> m_pedestals;
+        art::SubRunID m_pedestal_subrun;
+        float service_pedestal(const art::Event& event, int chid);
 
     };
 
@@ -0,0 +1,53 @@
+#include "SimDepoSetSource.h"
+
+#include "art/Framework/Principal/Event.h"
+
+#include "WireCellUtil/NamedFactory.h"
+#include "WireCellIface/SimpleDepoSet.h"
+
+WIRECELL_FACTORY(wclsSimDepoSetSource, wcls::SimDepoSetSource, wcls::IArtEventVisitor,
+                 WireCell::IDepoSetSource, WireCell::IConfigurable)
+
+using namespace wcls;
+
+SimDepoSetSource::SimDepoSetSource()
+{
+}
+
+SimDepoSetSource::~SimDepoSetSource()
+{
+}
+
+WireCell::Configuration SimDepoSetSource::default_configuration() const
+{
+    return m_source.default_configuration();
+}
+
+void SimDepoSetSource::configure(const WireCell::Configuration& cfg)
+{
+    m_source.configure(cfg);
+}
+
+void SimDepoSetSource::visit(art::Event & event)
+{
+    if (!m_sets.empty()) {
+        std::cerr << "SimDepoSetSource dropping " << m_sets.size()
+                  << " unused, prior depo sets\n";
+        m_sets.clear();
+    }
+
+    WireCell::IDepo::vector depos;
+    m_source.load(event, depos);
+    m_sets.push_back(std::make_shared<WireCell::SimpleDepoSet>(event.event(), depos));
+    m_sets.push_back(nullptr); // EOS marker
+}
+
+bool SimDepoSetSource::operator()(WireCell::IDepoSet::pointer& out)
+{
+    if (m_sets.empty()) {
+        return false;
+    }
+    out = m_sets.front();
+    m_sets.pop_front();
+    return true;
+}
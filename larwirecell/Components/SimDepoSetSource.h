@@ -0,0 +1,46 @@
+/** A sim depo set source provides all IDepo objects made from the LS
+    simulation objects of one art::Event as a single IDepoSet.
+
+    The conversion and configuration are exactly those of
+    SimDepoSource which this wraps.  The depos of the set share one
+    contiguous store so downstream WCT nodes which consume depo sets
+    may process them in bulk.  Each visit() produces one set followed
+    by an end-of-stream.
+*/
+
+#ifndef LARWIRECELL_COMPONENTS_SIMDEPOSETSOURCE
+#define LARWIRECELL_COMPONENTS_SIMDEPOSETSOURCE
+
+#include "SimDepoSource.h"
+
+#include "larwirecell/Interfaces/IArtEventVisitor.h"
+#include "WireCellIface/IDepoSetSource.h"
+#include "WireCellIface/IConfigurable.h"
+
+#include <deque>
+
+namespace wcls {
+
+    class SimDepoSetSource :  public IArtEventVisitor,
+                              public WireCell::IDepoSetSource,
+                              public WireCell::IConfigurable {
+    public:
+        SimDepoSetSource();
+        virtual ~SimDepoSetSource();
+
+        /// IArtEventVisitor
+        virtual void visit(art::Event & event);
+
+        /// IDepoSetSource
+        virtual bool operator()(WireCell::IDepoSet::pointer& out);
+
+        /// IConfigurable
+        virtual WireCell::Configuration default_configuration() const;
+        virtual void configure(const WireCell::Configuration& config);
+
+    private:
+        SimDepoSource m_source;
+        std::deque<WireCell::IDepoSet::pointer> m_sets;
+    };
+}
+#endif
@@ -18,6 +18,16 @@
 #include "WireCellUtil/NamedFactory.h"
 #include "WireCellIface/SimpleDepo.h"
 #include "WireCellIface/IRecombinationModel.h"
+#include "WireCellIface/IAnodePlane.h"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_sort.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
 
 WIRECELL_FACTORY(wclsSimDepoSource, wcls::SimDepoSource, wcls::IArtEventVisitor,
                  WireCell::IDepoSource, WireCell::IConfigurable)
@@ -29,54 +39,210 @@ namespace wcls {
     namespace bits {
 
         // There is more than one way to make ionization electrons.
-        // These adapters erase these differences.
-        class DepoAdapter {
-        public:
-            virtual ~DepoAdapter() {}
-            virtual double operator()(const sim::SimEnergyDeposit& sed) const = 0;
-        };
+        // These adapters erase these differences.  They are not
+        // virtual but are chosen at configure time by instantiating
+        // the batch kernel below for one of them.
 
         // This takes number of electrons directly, and applies a
         // multiplicative scale.
-        class ElectronsAdapter : public DepoAdapter {
+        struct ElectronsAdapter {
             double m_scale;
-        public:
-            ElectronsAdapter(double scale=1.0) : m_scale(scale) {}
-            virtual ~ElectronsAdapter() {};
-            virtual double operator()(const sim::SimEnergyDeposit& sed) const {
+            double operator()(const sim::SimEnergyDeposit& sed) const {
                 return m_scale * sed.NumElectrons();
             }
         };
 
         // This one takes a recombination model which only requires dE
         // (ie, assumes MIP).
-        class PointAdapter : public DepoAdapter {
+        struct PointAdapter {
             WireCell::IRecombinationModel::pointer m_model;
             double m_scale;
-        public:
-            PointAdapter(WireCell::IRecombinationModel::pointer model, double scale=1.0)
-                : m_model(model), m_scale(scale) {}
-            virtual ~PointAdapter() {}
-            virtual double operator()(const sim::SimEnergyDeposit& sed) const {
+            double operator()(const sim::SimEnergyDeposit& sed) const {
                 const double dE = sed.Energy()*units::MeV;
                 return m_scale * (*m_model)(dE);
             }
         };
 
         // This one takes a recombination which is a function of both dE and dX.
-        class StepAdapter : public DepoAdapter {
+        struct StepAdapter {
             WireCell::IRecombinationModel::pointer m_model;
             double m_scale;
-        public:
-            StepAdapter(WireCell::IRecombinationModel::pointer model, double scale=1.0)
-                : m_model(model), m_scale(scale) {}
-            virtual ~StepAdapter() {}
-            virtual double operator()(const sim::SimEnergyDeposit& sed) const {
+            double operator()(const sim::SimEnergyDeposit& sed) const {
                 const double dE = sed.Energy()*units::MeV;
                 const double dX = sed.StepLength()*units::cm;
                 return m_scale * (*m_model)(dE, dX);
             }
         };
+
+        // Fill the charge of each selected SED, in parallel.  The
+        // adapter call is inlined; only a recombination model, being
+        // a WCT component, remains a virtual call.
+        template <typename Adapter>
+        void charge_kernel(const Adapter& adapter,
+                           const std::vector<sim::SimEnergyDeposit>& sedv,
+                           const std::vector<size_t>& inds,
+                           std::vector<double>& charges)
+        {
+            charges.resize(inds.size());
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, inds.size()),
+                              [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t ind=r.begin(); ind != r.end(); ++ind) {
+                    charges[ind] = adapter(sedv[inds[ind]]);
+                }
+            });
+        }
+
+        template <typename Adapter>
+        SimDepoSource::charge_function make_charge_function(const Adapter& adapter)
+        {
+            return [adapter](const std::vector<sim::SimEnergyDeposit>& sedv,
+                             const std::vector<size_t>& inds,
+                             std::vector<double>& charges) {
+                charge_kernel(adapter, sedv, inds, charges);
+            };
+        }
+
+        WireCell::Point wct_point(const sim::SimEnergyDeposit& sed)
+        {
+            auto pt = sed.MidPoint();
+            return WireCell::Point(pt.x()*units::cm, pt.y()*units::cm, pt.z()*units::cm);
+        }
+
+        WireCell::SimpleDepo make_depo(const sim::SimEnergyDeposit& sed, double charge,
+                                       WireCell::IDepo::pointer prior)
+        {
+            return WireCell::SimpleDepo(sed.Time()*units::ns, wct_point(sed), charge, prior, 0.0, 0.0,
+                                        sed.TrackID(), sed.PdgCode(), sed.Energy()*units::MeV);
+        }
+
+        // Find the permutation which puts times in ascending order,
+        // ties by index, or leave order empty if they already are.
+        // The sort works on compact (time, index) keys.  Input is
+        // often a concatenation of time ordered runs (eg, the steps
+        // of each track) and if so the runs are merged pairwise, in
+        // parallel, else a parallel sort is used.
+        void time_order(const std::vector<double>& times, std::vector<size_t>& order)
+        {
+            order.clear();
+            const size_t nkeys = times.size();
+            if (std::is_sorted(times.begin(), times.end())) {
+                return;
+            }
+
+            typedef std::pair<double, size_t> key_t;
+            std::vector<key_t> keys(nkeys);
+            std::vector<size_t> runs{0};
+            for (size_t ind=0; ind<nkeys; ++ind) {
+                keys[ind] = key_t(times[ind], ind);
+                if (ind and times[ind] < times[ind-1]) {
+                    runs.push_back(ind);
+                }
+            }
+            runs.push_back(nkeys);
+
+            // Merging r runs costs n log r.  Mostly short runs are
+            // better left to the sort.
+            const size_t min_mean_run = 16;
+            if (runs.size() - 1 > nkeys / min_mean_run) {
+                tbb::parallel_sort(keys.begin(), keys.end());
+            }
+            else {
+                while (runs.size() > 2) {
+                    const size_t npairs = (runs.size() - 1) / 2;
+                    tbb::parallel_for(size_t(0), npairs, [&](size_t ipair) {
+                        auto beg = keys.begin() + runs[2*ipair];
+                        auto mid = keys.begin() + runs[2*ipair+1];
+                        auto end = keys.begin() + runs[2*ipair+2];
+                        std::inplace_merge(beg, mid, end);
+                    });
+                    std::vector<size_t> merged;
+                    for (size_t ind=0; ind<runs.size(); ind += 2) {
+                        merged.push_back(runs[ind]);
+                    }
+                    if (merged.back() != nkeys) {
+                        merged.push_back(nkeys);
+                    }
+                    runs.swap(merged);
+                }
+            }
+
+            order.resize(nkeys);
+            for (size_t ind=0; ind<nkeys; ++ind) {
+                order[ind] = keys[ind].second;
+            }
+        }
+
+        // The SEDs of one input tag and the groups made of them.
+        // The vectors are those held by the art::Event, not copies.
+        struct DepoInput {
+            const std::vector<sim::SimEnergyDeposit>* sedv{nullptr};
+            const std::vector<sim::SimEnergyDeposit>* assn_sedv{nullptr};
+            std::vector<size_t> inds, members, offsets;
+            std::vector<double> charges, assn_charges;
+            size_t first{0};    // index in the store of the first group
+            size_t ngroups() const { return offsets.size() - 1; }
+        };
+
+        const std::vector<sim::SimEnergyDeposit>* get_seds(art::Event& event, const art::InputTag& tag)
+        {
+            art::Handle< std::vector<sim::SimEnergyDeposit> > sedvh;
+            bool okay = event.getByLabel(tag, sedvh);
+            if (!okay) {
+                std::string msg = "SimDepoSource failed to get sim::SimEnergyDeposit from art tag: " + tag.encode();
+                std::cerr << msg << std::endl;
+                THROW(WireCell::RuntimeError() << WireCell::errmsg{msg});
+            }
+            return sedvh.product();
+        }
+
+        // Make one depo from the SEDs sedv[inds[m]] with charges[m]
+        // for each m of members.  Position and time are charge
+        // weighted centroids and the extents are the charge weighted
+        // spreads along X (longitudinal) and in Y-Z (transverse).
+        // Track ID and PDG code are those of the largest contributor.
+        WireCell::SimpleDepo merge_depo(const std::vector<sim::SimEnergyDeposit>& sedv,
+                                        const std::vector<size_t>& inds,
+                                        const std::vector<double>& charges,
+                                        const size_t* members, size_t nmembers,
+                                        WireCell::IDepo::pointer prior)
+        {
+            if (nmembers == 1) {
+                return make_depo(sedv[inds[members[0]]], charges[members[0]], prior);
+            }
+            double wsum = 0;
+            for (size_t im=0; im<nmembers; ++im) {
+                wsum += std::abs(charges[members[im]]);
+            }
+            const bool equal = wsum == 0;
+            if (equal) {
+                wsum = nmembers;
+            }
+
+            double qsum = 0, esum = 0, time = 0, wmax = -1;
+            WireCell::Point mean(0, 0, 0), mean2(0, 0, 0);
+            const sim::SimEnergyDeposit* dominant = nullptr;
+            for (size_t im=0; im<nmembers; ++im) {
+                const auto& sed = sedv[inds[members[im]]];
+                const double q = charges[members[im]];
+                const double w = (equal ? 1.0 : std::abs(q)) / wsum;
+                const WireCell::Point pt = wct_point(sed);
+                qsum += q;
+                esum += sed.Energy()*units::MeV;
+                time += w * sed.Time()*units::ns;
+                mean = mean + w * pt;
+                mean2 = mean2 + w * WireCell::Point(pt.x()*pt.x(), pt.y()*pt.y(), pt.z()*pt.z());
+                if (std::abs(q) > wmax) {
+                    wmax = std::abs(q);
+                    dominant = &sed;
+                }
+            }
+            auto spread = [](double m2, double m) { return std::sqrt(std::max(0.0, m2 - m*m)); };
+            const double extent_long = spread(mean2.x(), mean.x());
+            const double extent_tran = std::sqrt(0.5*(std::pow(spread(mean2.y(), mean.y()), 2) +
+                                                      std::pow(spread(mean2.z(), mean.z()), 2)));
+            return WireCell::SimpleDepo(time, mean, qsum, prior, extent_long, extent_tran,
+                                        dominant->TrackID(), dominant->PdgCode(), esum);
+        }
     }
 }
 
@@ -84,16 +250,11 @@ namespace wcls {
 using namespace wcls;
 
 SimDepoSource::SimDepoSource()
-    : m_adapter(nullptr)
 {
 }
 
 SimDepoSource::~SimDepoSource()
 {
-    if (m_adapter) {
-        delete m_adapter;
-        m_adapter = nullptr;
-    }
 }
 
 WireCell::Configuration SimDepoSource::default_configuration() const
@@ -112,147 +273,346 @@ WireCell::Configuration SimDepoSource::default_configuration() const
     cfg["art_tag"] = "";     // eg, "plopper:bogus"
     cfg["assn_art_tag"] = ""; // eg, "largeant"
 
+    // If given, these replace art_tag and assn_art_tag.  The SEDs
+    // of all art_tags are converted and merged into one time ordered
+    // stream of depos.  The assn_art_tags list, if given, pairs
+    // with art_tags and an empty entry means no associated SEDs.
+    cfg["art_tags"] = Json::arrayValue;
+    cfg["assn_art_tags"] = Json::arrayValue;
+
+    // Prefiltering.  If any anodes (IAnodePlane type:names) are
+    // given, only SEDs inside the sensitive volume of one of their
+    // faces, grown by margin in every direction, are kept.  To send
+    // depos of each anode to its own part of the graph, give all
+    // anodes here and route the output of a wclsSimDepoSetSource
+    // with a wclsDepoSetAnodeFanout.
+    cfg["anodes"] = Json::arrayValue;
+    cfg["margin"] = 0.0;
+    // If given as [begin, end], only SEDs with a time in this
+    // window are kept.
+    cfg["time_window"] = Json::arrayValue;
+
+    // If given as [dx, dy, dz, dt], kept SEDs which fall in the same
+    // voxel of this size are merged into one depo at their charge
+    // weighted centroid, with their spread as its extent and the
+    // track ID and PDG code of the one with the most charge.  A
+    // non-positive size does not divide that dimension.  Any
+    // associated (assn_art_tag) depos are merged alike.
+    cfg["coalesce"] = Json::arrayValue;
+
     return cfg;
 }
 void SimDepoSource::configure(const WireCell::Configuration& cfg)
 {
-    if (m_adapter) {
-        delete m_adapter;
-        m_adapter = nullptr;
-    }
     double scale = WireCell::get(cfg, "scale", 1.0);
 
     std::string model_tn = WireCell::get<std::string>(cfg, "model", "");
     std::string model_type = "";
     if (!model_tn.empty()) {
-        WireCell::String::split(model_tn)[0];
+        model_type = WireCell::String::split(model_tn)[0];
     }
 
+    m_charges = nullptr;
     if (model_type == "" or model_type == "electrons") {
-        m_adapter = new wcls::bits::ElectronsAdapter(scale);
+        m_charges = bits::make_charge_function(bits::ElectronsAdapter{scale});
     }
     else {
         auto model = WireCell::Factory::lookup_tn<WireCell::IRecombinationModel>(model_tn);
         if (!model) {
             std::cerr << "wcls::SimDepoSource: unknown recombination model: \"" << model_tn << "\"\n";
-            return;             // I should throw something here!
+            THROW(WireCell::ValueError() << WireCell::errmsg{"unknown recombination model: " + model_tn});
         }
         if (model_type == "MipRecombination") {
-            m_adapter = new wcls::bits::PointAdapter(model, scale);
+            m_charges = bits::make_charge_function(bits::PointAdapter{model, scale});
         }
         if (model_type == "BirksRecombination" || model_type == "BoxRecombination") {
-            m_adapter = new wcls::bits::StepAdapter(model, scale);
+            m_charges = bits::make_charge_function(bits::StepAdapter{model, scale});
+        }
+    }
+    if (!m_charges) {
+        THROW(WireCell::ValueError() << WireCell::errmsg{"unsupported recombination model: " + model_tn});
+    }
+
+    m_inputTags.clear();
+    m_assnTags.clear();
+    auto jtags = cfg["art_tags"];
+    if (jtags.isArray() and jtags.size()) {
+        auto jassns = cfg["assn_art_tags"];
+        if (jassns.size() and jassns.size() != jtags.size()) {
+            THROW(WireCell::ValueError() << WireCell::errmsg{"SimDepoSource: assn_art_tags must pair with art_tags"});
         }
+        for (Json::ArrayIndex ind=0; ind<jtags.size(); ++ind) {
+            m_inputTags.push_back(art::InputTag(jtags[ind].asString()));
+            m_assnTags.push_back(art::InputTag(jassns.size() ? jassns[ind].asString() : ""));
+        }
+    }
+    else {
+        m_inputTags.push_back(art::InputTag(cfg["art_tag"].asString()));
+        m_assnTags.push_back(art::InputTag(cfg["assn_art_tag"].asString()));
+    }
+
+    m_boxes.clear();
+    const double margin = WireCell::get(cfg, "margin", 0.0);
+    for (auto janode : cfg["anodes"]) {
+        auto boxes = sensitive_boxes(janode.asString(), margin);
+        m_boxes.insert(m_boxes.end(), boxes.begin(), boxes.end());
     }
 
-    m_inputTag = cfg["art_tag"].asString();
-    m_assnTag = cfg["assn_art_tag"].asString();
+    m_voxel.clear();
+    auto jvox = cfg["coalesce"];
+    if (jvox.isArray() and jvox.size()) {
+        if (jvox.size() != 4) {
+            THROW(WireCell::ValueError() << WireCell::errmsg{"SimDepoSource: coalesce needs [dx, dy, dz, dt]"});
+        }
+        for (auto jv : jvox) {
+            m_voxel.push_back(jv.asDouble());
+        }
+    }
+
+    auto jtw = cfg["time_window"];
+    m_time_window = jtw.isArray() and jtw.size() == 2;
+    if (m_time_window) {
+        m_tbegin = jtw[0].asDouble();
+        m_tend = jtw[1].asDouble();
+    }
 }
 
+std::vector<WireCell::BoundingBox> SimDepoSource::sensitive_boxes(const std::string& anode_tn,
+                                                                  double margin)
+{
+    std::vector<WireCell::BoundingBox> boxes;
+    const WireCell::Point grow(margin, margin, margin);
+    auto anode = WireCell::Factory::find_tn<WireCell::IAnodePlane>(anode_tn);
+    for (auto face : anode->faces()) {
+        if (!face) {
+            continue;
+        }
+        const WireCell::Ray bounds = face->sensitive().bounds();
+        boxes.push_back(WireCell::BoundingBox(
+            WireCell::Ray(bounds.first - grow, bounds.second + grow)));
+    }
+    return boxes;
+}
 
-void SimDepoSource::visit(art::Event & event)
+void SimDepoSource::coalesce(const std::vector<sim::SimEnergyDeposit>& sedv,
+                             const std::vector<size_t>& inds,
+                             std::vector<size_t>& members, std::vector<size_t>& offsets) const
 {
-    art::Handle< std::vector<sim::SimEnergyDeposit> > sedvh;
+    // Voxel key of each kept SED, found in parallel.
+    typedef std::array<int64_t, 4> key_t;
+    const size_t nkeep = inds.size();
+    std::vector<key_t> keys(nkeep);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, nkeep),
+                      [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t ind=r.begin(); ind != r.end(); ++ind) {
+            const auto& sed = sedv[inds[ind]];
+            const WireCell::Point pt = bits::wct_point(sed);
+            const double coords[4] = {pt.x(), pt.y(), pt.z(), sed.Time()*units::ns};
+            for (size_t dim=0; dim<4; ++dim) {
+                keys[ind][dim] = m_voxel[dim] > 0 ? static_cast<int64_t>(std::floor(coords[dim]/m_voxel[dim])) : 0;
+            }
+        }
+    });
+
+    tbb::parallel_sort(members.begin(), members.end(), [&](size_t a, size_t b) {
+        return keys[a] < keys[b];
+    });
 
-    bool okay = event.getByLabel(m_inputTag, sedvh);
-    if (!okay) {
-        std::string msg = "SimDepoSource failed to get sim::SimEnergyDeposit from art tag: " + m_inputTag.encode();
-        std::cerr << msg << std::endl;
-        THROW(WireCell::RuntimeError() << WireCell::errmsg{msg});
+    offsets.clear();
+    for (size_t im=0; im<nkeep; ++im) {
+        if (im == 0 or keys[members[im]] != keys[members[im-1]]) {
+            offsets.push_back(im);
+        }
     }
-    //else if (sedvh->empty()) return;
+    offsets.push_back(nkeep);
+}
 
-    const size_t ndepos = sedvh->size();
+bool SimDepoSource::keep(const sim::SimEnergyDeposit& sed) const
+{
+    if (m_time_window) {
+        const double time = sed.Time()*units::ns;
+        if (time < m_tbegin or time >= m_tend) {
+            return false;
+        }
+    }
+    if (m_boxes.empty()) {
+        return true;
+    }
+    const WireCell::Point pt = bits::wct_point(sed);
+    for (const auto& box : m_boxes) {
+        if (box.inside(pt)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    std::cerr << "SimDepoSource got " << ndepos
-              << " depos from art tag \"" << m_inputTag
-              << "\" returns: " << (okay ? "okay" : "fail") << std::endl;
 
+void SimDepoSource::visit(art::Event & event)
+{
     if (!m_depos.empty()) {
         std::cerr << "SimDepoSource dropping " << m_depos.size()
                   << " unused, prior depos\n";
         m_depos.clear();
     }
 
-    // associate the input SED with the other set of SED (eg, before SCE)
-    std::vector<sim::SimEnergyDeposit> assn_sedv;
-    if (m_assnTag!="") {
-        art::Handle< std::vector<sim::SimEnergyDeposit> > assn_sedvh;
-        okay = event.getByLabel(m_assnTag, assn_sedvh);
-        if (!okay) {
-            std::string msg = "SimDepoSource failed to get sim::SimEnergyDeposit from art tag: " + m_assnTag.encode();
-            std::cerr << msg << std::endl;
-            THROW(WireCell::RuntimeError() << WireCell::errmsg{msg});
+    WireCell::IDepo::vector depos;
+    load(event, depos);
+    m_depos.insert(m_depos.end(), depos.begin(), depos.end());
+    m_depos.push_back(nullptr); // EOS marker
+}
+
+void SimDepoSource::load(art::Event & event, WireCell::IDepo::vector& depos)
+{
+    // Input SEDs are used in place through their handles.  The art
+    // lookups are serial, the conversion of each input is parallel.
+    const size_t ninputs = m_inputTags.size();
+    std::vector<bits::DepoInput> inputs(ninputs);
+    for (size_t iin=0; iin<ninputs; ++iin) {
+        auto& input = inputs[iin];
+        input.sedv = bits::get_seds(event, m_inputTags[iin]);
+        const size_t ndepos = input.sedv->size();
+
+        std::cerr << "SimDepoSource got " << ndepos
+                  << " depos from art tag \"" << m_inputTags[iin]
+                  << "\"" << std::endl;
+
+        // associate the input SED with the other set of SED (eg, before SCE)
+        if (m_assnTags[iin]!="") {
+            input.assn_sedv = bits::get_seds(event, m_assnTags[iin]);
+            std::cout << "Larwirecell::SimDepoSource got " << input.assn_sedv->size()
+                      << " associated depos from " << m_assnTags[iin] << std::endl;
+            // safty check for the associated SED
+            if (ndepos != input.assn_sedv->size()) {
+                std::string msg = "Larwirecell::SimDepoSource Inconsistent size of SimDepoSources";
+                std::cerr << msg << std::endl;
+                THROW(WireCell::RuntimeError() << WireCell::errmsg{msg});
+            }
+        }
+    }
+
+    tbb::parallel_for(size_t(0), ninputs, [&](size_t iin) {
+        auto& input = inputs[iin];
+        const auto& sedv = *input.sedv;
+        const size_t ndepos = sedv.size();
+
+        // Select the SEDs to keep before any further work.  The
+        // selection flags are found in parallel.
+        auto& inds = input.inds;
+        if (m_boxes.empty() and !m_time_window) {
+            inds.resize(ndepos);
+            std::iota(inds.begin(), inds.end(), 0);
         }
         else {
-            std::cout << "Larwirecell::SimDepoSource got " << assn_sedvh->size() 
-                      << " associated depos from " << m_assnTag << std::endl;
-            assn_sedv.insert(assn_sedv.end(), assn_sedvh->begin(), assn_sedvh->end() );
+            std::vector<char> keeps(ndepos, 0);
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, ndepos),
+                              [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t ind=r.begin(); ind != r.end(); ++ind) {
+                    keeps[ind] = keep(sedv[ind]);
+                }
+            });
+            for (size_t ind=0; ind<ndepos; ++ind) {
+                if (keeps[ind]) {
+                    inds.push_back(ind);
+                }
+            }
         }
-        // safty check for the associated SED
-        if (ndepos != assn_sedv.size()) {
-            std::string msg = "Larwirecell::SimDepoSource Inconsistent size of SimDepoSources";
-            std::cerr << msg << std::endl;
-            THROW(WireCell::RuntimeError() << WireCell::errmsg{msg});
+        const size_t nkeep = inds.size();
+
+        // The number of electrons of all kept SEDs in one parallel batch.
+        m_charges(sedv, inds, input.charges);
+        if (input.assn_sedv) {
+            m_charges(*input.assn_sedv, inds, input.assn_charges);
         }
-    }
 
-    for (size_t ind=0; ind<ndepos; ++ind) {
-        auto const& sed = sedvh->at(ind);
-        auto pt = sed.MidPoint();
-        const WireCell::Point wpt(pt.x()*units::cm, pt.y()*units::cm, pt.z()*units::cm);
-        double wt = sed.Time()*units::ns;
-        double wq = (*m_adapter)(sed);
-        int wid = sed.TrackID();
-        int pdg = sed.PdgCode();
-        double we = sed.Energy()*units::MeV;
-
-        if (assn_sedv.size() == 0) {
-            WireCell::IDepo::pointer depo
-                = std::make_shared<WireCell::SimpleDepo>(wt, wpt, wq, nullptr, 0.0, 0.0, wid, pdg, we);
-            m_depos.push_back(depo);
-            // std::cerr << ind << ": t=" << wt/units::us << "us,"
-            //           << " r=" << wpt/units::cm << "cm, "
-            //           << " q=" << wq
-            //           << " e=" << we/units::MeV << "\n";
+        // Group the kept SEDs into depos.  Group igroup is made of the
+        // SEDs at members[offsets[igroup]] up to members[offsets[igroup+1]]
+        // where members index inds.  Without coalescing each SED is its
+        // own group.
+        input.members.resize(nkeep);
+        std::iota(input.members.begin(), input.members.end(), 0);
+        if (m_voxel.empty()) {
+            input.offsets.resize(nkeep + 1);
+            std::iota(input.offsets.begin(), input.offsets.end(), 0);
         }
         else {
-            auto const& sed1 = assn_sedv.at(ind);
-            auto pt1 = sed1.MidPoint();
-            const WireCell::Point wpt1(pt1.x()*units::cm, pt1.y()*units::cm, pt1.z()*units::cm);
-            double wt1 = sed1.Time()*units::ns;
-            double wq1 = (*m_adapter)(sed1);
-            int wid1 = sed1.TrackID();
-            int pdg1 = sed1.PdgCode();
-            double we1 = sed1.Energy()*units::MeV;
-
-            WireCell::IDepo::pointer assn_depo
-            = std::make_shared<WireCell::SimpleDepo>(wt1, wpt1, wq1, nullptr, 0.0, 0.0, wid1, pdg1, we1);
-
-            WireCell::IDepo::pointer depo
-                = std::make_shared<WireCell::SimpleDepo>(wt, wpt, wq, assn_depo, 0.0, 0.0, wid, pdg, we);
-            m_depos.push_back(depo);
-            // std::cerr << ind << ": t1=" << wt1/units::us << "us,"
-            //           << " r1=" << wpt1/units::cm << "cm, "
-            //           << " q1=" << wq1
-            //           << " e1=" << we1/units::MeV << "\n";
+            coalesce(sedv, inds, input.members, input.offsets);
+        }
+    });
+
+    size_t ngroups = 0;
+    bool any_assn = false;
+    for (size_t iin=0; iin<ninputs; ++iin) {
+        auto& input = inputs[iin];
+        if (!m_boxes.empty() or m_time_window) {
+            std::cerr << "SimDepoSource: prefilter keeps " << input.inds.size()
+                      << " of " << input.sedv->size() << " depos from \""
+                      << m_inputTags[iin] << "\"\n";
         }
+        if (!m_voxel.empty()) {
+            std::cerr << "SimDepoSource: coalesced " << input.inds.size() << " depos to "
+                      << input.ngroups() << " from \"" << m_inputTags[iin] << "\"\n";
+        }
+        input.first = ngroups;
+        ngroups += input.ngroups();
+        any_assn = any_assn or input.assn_sedv;
+    }
+
+    // All depos, and separately any prior depos, are allocated in
+    // one go.  Each IDepo::pointer aliases its store so the store
+    // lives as long as any of its depos.  Priors are kept apart so
+    // no store refers to itself.  Slots are filled in parallel.
+    const WireCell::SimpleDepo blank(0, WireCell::Point(0, 0, 0), 0);
+    auto store = std::make_shared<std::vector<WireCell::SimpleDepo>>(std::max<size_t>(ngroups, 1), blank);
+    std::shared_ptr<std::vector<WireCell::SimpleDepo>> prior_store;
+    if (any_assn) {
+        prior_store = std::make_shared<std::vector<WireCell::SimpleDepo>>(ngroups, blank);
+    }
+    depos.resize(ngroups);
+    std::vector<double> times(ngroups);
+
+    for (const auto& input : inputs) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, input.ngroups()),
+                          [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t igroup=r.begin(); igroup != r.end(); ++igroup) {
+                const size_t islot = input.first + igroup;
+                const size_t* gmembers = input.members.data() + input.offsets[igroup];
+                const size_t nmembers = input.offsets[igroup+1] - input.offsets[igroup];
+                WireCell::IDepo::pointer assn_depo;
+                if (input.assn_sedv) {
+                    auto& prior = (*prior_store)[islot];
+                    prior = bits::merge_depo(*input.assn_sedv, input.inds, input.assn_charges,
+                                             gmembers, nmembers, nullptr);
+                    assn_depo = WireCell::IDepo::pointer(prior_store, &prior);
+                }
+                auto& depo = (*store)[islot];
+                depo = bits::merge_depo(*input.sedv, input.inds, input.charges,
+                                        gmembers, nmembers, assn_depo);
+                depos[islot] = WireCell::IDepo::pointer(store, &depo);
+                times[islot] = depo.time();
+            }
+        });
     }
 
     // empty "ionization": no TPC activity
-    if (ndepos == 0) {
-	    WireCell::Point wpt(0, 0, 0);
-	    WireCell::IDepo::pointer depo
-		    = std::make_shared<WireCell::SimpleDepo>(0, wpt, 0, nullptr, 0.0, 0.0);
-	    m_depos.push_back(depo);
+    if (ngroups == 0) {
+	    depos.push_back(WireCell::IDepo::pointer(store, &store->front()));
     }
 
-    // don't trust user to honor time ordering.
-    std::sort(m_depos.begin(), m_depos.end(), WireCell::ascending_time);
-    std::cerr << "SimDepoSource: ready with " << m_depos.size() << " depos spanning: ["
-              << m_depos.front()->time()/units::us << ", "
-              << m_depos.back()->time()/units::us << "]us\n";
-    m_depos.push_back(nullptr); // EOS marker
+    // don't trust user to honor time ordering.  Each input is
+    // typically already ordered and so is one run to merge.
+    std::vector<size_t> order;
+    bits::time_order(times, order);
+    if (!order.empty()) {
+        WireCell::IDepo::vector sorted(depos.size());
+        for (size_t ind=0; ind<order.size(); ++ind) {
+            sorted[ind] = std::move(depos[order[ind]]);
+        }
+        depos.swap(sorted);
+    }
+    std::cerr << "SimDepoSource: ready with " << depos.size() << " depos spanning: ["
+              << depos.front()->time()/units::us << ", "
+              << depos.back()->time()/units::us << "]us\n";
 }
 
 bool SimDepoSource::operator()(WireCell::IDepo::pointer& out)
@@ -10,7 +10,9 @@
     2) Allow for multiple, independent vectors of SimEnergyDeposit
     otherwise as above to each be ingested into WCT on each art::Event
     and let WCT properly mix them (eg with WCT's Gen::DepoMerger
-    component).
+    component).  This converter also does this itself when given
+    several art_tags, merging their depos into one stream in time
+    order.
 
     3) As above but relax treating each art::Event atomically and
     allow accumulation of depos spanning multiple visit()'s.  This can
@@ -20,6 +22,17 @@
     need to spit out discrete frames but it can do so such that their
     boundaries can be stitched together seemlessly.
 
+    SEDs outside of the sensitive volumes of configured anodes or
+    outside a time window may be dropped before they are converted
+    and those remaining may be coalesced into fewer depos by voxel.
+    To route depos to per-anode parts of a graph, follow a
+    SimDepoSetSource with a DepoSetAnodeFanout so that the event is
+    converted only once.
+
+    The depos of one visit() are held in one contiguous store and
+    handed out as shared pointers which alias it.  SimDepoSetSource
+    uses the same conversion to hand them out as one IDepoSet.
+
 */
 
 #ifndef LARWIRECELL_COMPONENTS_SIMDEPOSOURCE
@@ -29,15 +42,20 @@
 #include "WireCellIface/IDepoSource.h"
 #include "WireCellIface/IConfigurable.h"
 #include "WireCellIface/IDepo.h"
+#include "WireCellUtil/BoundingBox.h"
 #include "canvas/Utilities/InputTag.h"
 
 #include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sim {
+    class SimEnergyDeposit;
+}
 
 namespace wcls {
 
-    namespace bits {
-        class DepoAdapter;
-    }
 
     class SimDepoSource :  public IArtEventVisitor,
                            public WireCell::IDepoSource,
@@ -56,12 +74,40 @@ namespace wcls {
         virtual WireCell::Configuration default_configuration() const;
         virtual void configure(const WireCell::Configuration& config);
 
+        /// Convert the configured SimEnergyDeposits of the event to
+        /// depos in ascending time order.  If there are none, a
+        /// single empty depo is given.
+        void load(art::Event& event, WireCell::IDepo::vector& depos);
+
+        /// The sensitive volumes of the faces of an anode (by
+        /// IAnodePlane type:name), grown by margin in each direction.
+        static std::vector<WireCell::BoundingBox> sensitive_boxes(const std::string& anode_tn,
+                                                                  double margin);
+
+        /// Fill the number of electrons of each SED of sedv at inds.
+        typedef std::function<void(const std::vector<sim::SimEnergyDeposit>& sedv,
+                                   const std::vector<size_t>& inds,
+                                   std::vector<double>& charges)> charge_function;
+
     private:
         std::deque<WireCell::IDepo::pointer> m_depos;
-        bits::DepoAdapter* m_adapter;
-
-        art::InputTag m_inputTag;
-        art::InputTag m_assnTag; // associated input
+        charge_function m_charges;
+
+        // prefilter by anode sensitive volumes and time
+        std::vector<WireCell::BoundingBox> m_boxes;
+        bool m_time_window{false};
+        double m_tbegin{0}, m_tend{0};
+        bool keep(const sim::SimEnergyDeposit& sed) const;
+
+        // coalescing voxel size in x, y, z and time, empty if off
+        std::vector<double> m_voxel;
+        void coalesce(const std::vector<sim::SimEnergyDeposit>& sedv,
+                      const std::vector<size_t>& inds,
+                      std::vector<size_t>& members, std::vector<size_t>& offsets) const;
+
+        // input SEDs and, for each, any associated SEDs or an empty tag
+        std::vector<art::InputTag> m_inputTags;
+        std::vector<art::InputTag> m_assnTags;
     };
 }
 #endif
@@ -0,0 +1,110 @@
+#include "larwirecell/DataProducts/ChannelMasks.h"
+
+using namespace wcls;
+
+ChannelMasks::ChannelMasks() : fFirstChannel(0), fNBits(0) {}
+
+ChannelMasks::ChannelMasks(const mask_map_t& masks) : fFirstChannel(0), fNBits(0)
+{
+    if (masks.empty()) {
+        return;
+    }
+    fFirstChannel = masks.begin()->first;
+    fNBits = masks.rbegin()->first - fFirstChannel + 1;
+    const size_t nwords = (fNBits + 63) / 64;
+    fBitmap.assign(nwords, 0);
+
+    size_t nranges = 0;
+    for (const auto& cm : masks) {
+        nranges += cm.second.size();
+    }
+    fOffset.reserve(masks.size() + 1);
+    fBegin.reserve(nranges);
+    fLength.reserve(nranges);
+
+    fOffset.push_back(0);
+    for (const auto& cm : masks) {
+        const unsigned int bit = cm.first - fFirstChannel;
+        fBitmap[bit / 64] |= uint64_t(1) << (bit % 64);
+        for (const auto& be : cm.second) {
+            fBegin.push_back(be.first);
+            fLength.push_back(be.second - be.first);
+        }
+        fOffset.push_back(fBegin.size());
+    }
+
+    fRank.resize(nwords);
+    unsigned int rank = 0;
+    for (size_t iword = 0; iword < nwords; ++iword) {
+        fRank[iword] = rank;
+        rank += __builtin_popcountll(fBitmap[iword]);
+    }
+}
+
+long ChannelMasks::Row(int channel) const
+{
+    if (channel < fFirstChannel) {
+        return -1;
+    }
+    const unsigned int bit = channel - fFirstChannel;
+    if (bit >= fNBits) {
+        return -1;
+    }
+    const uint64_t word = fBitmap[bit / 64];
+    const uint64_t mask = uint64_t(1) << (bit % 64);
+    if (!(word & mask)) {
+        return -1;
+    }
+    return fRank[bit / 64] + __builtin_popcountll(word & (mask - 1));
+}
+
+bool ChannelMasks::Masked(int channel) const
+{
+    return Row(channel) >= 0;
+}
+
+std::vector<int> ChannelMasks::Channels() const
+{
+    std::vector<int> ret;
+    ret.reserve(NChannels());
+    for (size_t iword = 0; iword < fBitmap.size(); ++iword) {
+        uint64_t word = fBitmap[iword];
+        while (word) {
+            const int bit = __builtin_ctzll(word);
+            ret.push_back(fFirstChannel + 64 * iword + bit);
+            word &= word - 1;
+        }
+    }
+    return ret;
+}
+
+ChannelMasks::ranges_t ChannelMasks::Ranges(int channel) const
+{
+    ranges_t ret;
+    const long row = Row(channel);
+    if (row < 0) {
+        return ret;
+    }
+    for (unsigned int ind = fOffset[row]; ind < fOffset[row + 1]; ++ind) {
+        ret.emplace_back(fBegin[ind], fBegin[ind] + fLength[ind]);
+    }
+    return ret;
+}
+
+ChannelMasks::mask_map_t ChannelMasks::AsMap() const
+{
+    mask_map_t ret;
+    const auto channels = Channels();
+    for (size_t row = 0; row < channels.size(); ++row) {
+        auto& ranges = ret[channels[row]];
+        for (unsigned int ind = fOffset[row]; ind < fOffset[row + 1]; ++ind) {
+            ranges.emplace_back(fBegin[ind], fBegin[ind] + fLength[ind]);
+        }
+    }
+    return ret;
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
@@ -0,0 +1,71 @@
+/** A compact form of one named WCT channel mask map.
+ *
+ * Masked channels are marked in a bitmap which spans from the lowest
+ * to the highest masked channel.  The masked tick ranges of each
+ * masked channel, in channel order, are stored run-length style as a
+ * begin tick and a length in a compressed sparse row layout.
+ *
+ * As a WCT channel mask, a range is [begin, end) with end one past
+ * the last masked tick.
+ */
+
+#ifndef LARWIRECELL_DATAPRODUCTS_CHANNELMASKS
+#define LARWIRECELL_DATAPRODUCTS_CHANNELMASKS
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace wcls {
+
+    class ChannelMasks {
+    public:
+        /// Tick ranges [begin, end) of one channel.
+        typedef std::vector<std::pair<int, int>> ranges_t;
+        /// The same type as a WireCell::Waveform::ChannelMasks.
+        typedef std::map<int, ranges_t> mask_map_t;
+
+        /// Default constructor is for ROOT I/O and is empty.
+        ChannelMasks();
+
+        explicit ChannelMasks(const mask_map_t& masks);
+
+        /// The number of masked channels.
+        size_t NChannels() const { return fOffset.empty() ? 0 : fOffset.size() - 1; }
+
+        /// True if the channel has any mask.
+        bool Masked(int channel) const;
+
+        /// The masked channels in increasing order.
+        std::vector<int> Channels() const;
+
+        /// The masked tick ranges of a channel, empty if none.
+        ranges_t Ranges(int channel) const;
+
+        /// All masks as WCT holds them.
+        mask_map_t AsMap() const;
+
+    private:
+        int fFirstChannel;
+        unsigned int fNBits;
+        std::vector<uint64_t> fBitmap;
+        // number of set bits before each bitmap word
+        std::vector<unsigned int> fRank;
+        // ranges of the i'th masked channel are at [fOffset[i], fOffset[i+1])
+        std::vector<unsigned int> fOffset;
+        std::vector<int> fBegin, fLength;
+
+        // Index of a masked channel in channel order, -1 if not masked.
+        long Row(int channel) const;
+    };
+
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
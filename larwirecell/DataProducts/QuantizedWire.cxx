@@ -0,0 +1,99 @@
+#include "larwirecell/DataProducts/QuantizedWire.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace wcls;
+
+QuantizedWire::QuantizedWire()
+    : fChannel(raw::InvalidChannelID)
+    , fView(geo::kUnknown)
+    , fNSignal(0)
+    , fScale(1.0)
+{
+}
+
+QuantizedWire::QuantizedWire(const recob::Wire::RegionsOfInterest_t& rois,
+                             raw::ChannelID_t channel, geo::View_t view, float scale)
+    : fChannel(channel)
+    , fView(view)
+    , fNSignal(rois.size())
+    , fScale(scale)
+{
+    const auto& ranges = rois.get_ranges();
+
+    // Coarsen the step rather than saturate.
+    const float qmax = std::numeric_limits<sample_t>::max();
+    float vmax = 0;
+    size_t nsamples = 0;
+    for (const auto& range : ranges) {
+        for (float v : range.data()) {
+            vmax = std::max(vmax, std::abs(v));
+        }
+        nsamples += range.size();
+    }
+    if (vmax > qmax * fScale) {
+        fScale = vmax / qmax;
+    }
+
+    fROIBegin.reserve(ranges.size());
+    fROILength.reserve(ranges.size());
+    fSamples.reserve(nsamples);
+    const float inv = 1.0 / fScale;
+    for (const auto& range : ranges) {
+        fROIBegin.push_back(range.begin_index());
+        fROILength.push_back(range.size());
+        for (float v : range.data()) {
+            const float q = std::min(qmax, std::max(-qmax, v * inv));
+            fSamples.push_back(static_cast<sample_t>(std::lround(q)));
+        }
+    }
+}
+
+std::vector<QuantizedWire::ROI> QuantizedWire::ROIs() const
+{
+    std::vector<ROI> ret;
+    ret.reserve(fROIBegin.size());
+    const sample_t* q = fSamples.data();
+    for (size_t iroi = 0; iroi < fROIBegin.size(); ++iroi) {
+        ret.emplace_back(fROIBegin[iroi], fROILength[iroi], q, fScale);
+        q += fROILength[iroi];
+    }
+    return ret;
+}
+
+recob::Wire::RegionsOfInterest_t QuantizedWire::SignalROI() const
+{
+    recob::Wire::RegionsOfInterest_t rois(fNSignal);
+    for (const auto& roi : ROIs()) {
+        std::vector<float> data(roi.size());
+        for (size_t ind = 0; ind < data.size(); ++ind) {
+            data[ind] = roi[ind];
+        }
+        rois.add_range(roi.begin_index(), std::move(data));
+    }
+    return rois;
+}
+
+std::vector<float> QuantizedWire::Signal() const
+{
+    std::vector<float> wave(fNSignal, 0.0);
+    for (const auto& roi : ROIs()) {
+        float* out = wave.data() + roi.begin_index();
+        for (size_t ind = 0; ind < roi.size(); ++ind) {
+            out[ind] = roi[ind];
+        }
+    }
+    return wave;
+}
+
+recob::Wire QuantizedWire::AsWire() const
+{
+    return recob::Wire(SignalROI(), fChannel, fView);
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
@@ -0,0 +1,104 @@
+/** A compact form of recob::Wire.
+ *
+ * The signal regions of interest (ROIs) are kept as a begin tick and
+ * a length and their samples are quantized to short integers with a
+ * per-channel step ("scale").  A sample is recovered as its quantized
+ * value times the scale.
+ *
+ * ROIs() gives light views of the ROIs which read the quantized
+ * samples in place.  The SignalROI(), Signal() and AsWire() methods
+ * instead copy the content into the form of recob::Wire so that
+ * consumers need not know about the quantization.
+ */
+
+#ifndef LARWIRECELL_DATAPRODUCTS_QUANTIZEDWIRE
+#define LARWIRECELL_DATAPRODUCTS_QUANTIZEDWIRE
+
+#include "larcoreobj/SimpleTypesAndConstants/RawTypes.h"
+#include "larcoreobj/SimpleTypesAndConstants/geo_types.h"
+#include "lardataobj/RecoBase/Wire.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace wcls {
+
+    class QuantizedWire {
+    public:
+        typedef short sample_t;
+
+        /// A view of one ROI which reads its quantized samples in
+        /// place.  It is valid while its QuantizedWire lives.
+        class ROI {
+        public:
+            ROI(size_t begin, size_t length, const sample_t* samples, float scale)
+                : m_begin(begin), m_length(length), m_samples(samples), m_scale(scale) {}
+
+            /// The first tick, one past the last tick and the number of ticks.
+            size_t begin_index() const { return m_begin; }
+            size_t end_index() const { return m_begin + m_length; }
+            size_t size() const { return m_length; }
+
+            /// The quantized and the recovered sample, by index into the ROI.
+            sample_t quantized(size_t ind) const { return m_samples[ind]; }
+            float operator[](size_t ind) const { return m_samples[ind] * m_scale; }
+
+        private:
+            size_t m_begin, m_length;
+            const sample_t* m_samples;
+            float m_scale;
+        };
+
+        /// Default constructor is for ROOT I/O.
+        QuantizedWire();
+
+        /// Quantize the ROIs with a step of scale, made coarser if
+        /// needed so that no sample overflows a sample_t.
+        QuantizedWire(const recob::Wire::RegionsOfInterest_t& rois,
+                      raw::ChannelID_t channel, geo::View_t view, float scale);
+
+        raw::ChannelID_t Channel() const { return fChannel; }
+        geo::View_t View() const { return fView; }
+
+        /// The number of ticks of the full waveform.
+        size_t NSignal() const { return fNSignal; }
+
+        /// The quantization step.
+        float Scale() const { return fScale; }
+
+        /// The ROIs and their quantized samples, which are
+        /// concatenated in Samples() in ROI order.
+        size_t NROIs() const { return fROIBegin.size(); }
+        size_t ROIBegin(size_t iroi) const { return fROIBegin[iroi]; }
+        size_t ROILength(size_t iroi) const { return fROILength[iroi]; }
+        const std::vector<sample_t>& Samples() const { return fSamples; }
+
+        /// Views of the ROIs in order, without copying samples.
+        std::vector<ROI> ROIs() const;
+
+        /// A copy of the ROIs as for recob::Wire::SignalROI().
+        recob::Wire::RegionsOfInterest_t SignalROI() const;
+
+        /// The dense waveform as for recob::Wire::Signal().
+        std::vector<float> Signal() const;
+
+        /// The equivalent recob::Wire.
+        recob::Wire AsWire() const;
+
+    private:
+        raw::ChannelID_t fChannel;
+        geo::View_t fView;
+        unsigned int fNSignal;
+        float fScale;
+        std::vector<unsigned int> fROIBegin, fROILength;
+        std::vector<sample_t> fSamples;
+    };
+
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
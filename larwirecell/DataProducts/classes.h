@@ -0,0 +1,5 @@
+#include "canvas/Persistency/Common/Wrapper.h"
+#include "larwirecell/DataProducts/ChannelMasks.h"
+#include "larwirecell/DataProducts/QuantizedWire.h"
+
+#include <vector>
@@ -18,6 +18,8 @@
 
 #include "lardataobj/RawData/RawDigit.h"
 
+#include "larwirecell/Utilities/RawAdcs.h"
+
 #include "WireCellUtil/Units.h"
 
 #include "WireCellIface/SimpleFrame.h"
@@ -26,6 +28,7 @@
 #include "WireCellSigProc/OmnibusNoiseFilter.h"
 #include "WireCellSigProc/SimpleChannelNoiseDB.h"
 
+#include <algorithm>
 #include <numeric> // iota
 #include <string>
 
@@ -95,9 +98,9 @@ namespace noisefilteralg {
       const std::vector<raw::RawDigit>& rawDigitVector(*rawDigitHandle);
 
       // Make sure we have the correct window size (e.g. window size = 9600 but data is 9595)
-      size_t windowSize(std::min(fWindowSize, rawDigitVector.at(0).NADC()));
+      size_t windowSize(std::min(fWindowSize, wcls::RawAdcs::nsamples(rawDigitVector.at(0))));
 
-      if (fNumTicksToDropFront + windowSize > rawDigitVector.at(0).NADC())
+      if (fNumTicksToDropFront + windowSize > wcls::RawAdcs::nsamples(rawDigitVector.at(0)))
         throw cet::exception("WireCellNoiseFilter")
           << "Ticks to drop + windowsize larger than input buffer\n";
 
@@ -109,11 +112,12 @@ namespace noisefilteralg {
         size_t stopBin(startBin + windowSize);
 
         raw::RawDigit::ADCvector_t outputVector(windowSize);
+        raw::RawDigit::ADCvector_t buffer;
 
         for (const auto& rawDigit : rawDigitVector) {
-          if (rawDigit.NADC() < windowSize) continue;
+          if (wcls::RawAdcs::nsamples(rawDigit) < windowSize) continue;
 
-          const raw::RawDigit::ADCvector_t& rawAdcVec = rawDigit.ADCs();
+          const raw::RawDigit::ADCvector_t& rawAdcVec = wcls::RawAdcs::samples(rawDigit, buffer);
 
           unsigned int channel = rawDigit.Channel();
           float pedestal = pedestalValues.PedMean(channel);
@@ -154,7 +158,7 @@ namespace noisefilteralg {
 
     // S&C microboone sampling parameter database
     const double tick = sampling_rate(clock_data); // 0.5 * units::microsecond;
-    const size_t nsamples = inputWaveforms.at(0).NADC();
+    const size_t nsamples = wcls::RawAdcs::nsamples(inputWaveforms.at(0));
     const size_t windowSize = std::min(fWindowSize, nsamples);
 
     // Q&D microboone channel map
@@ -390,22 +394,21 @@ namespace noisefilteralg {
 
     //load waveforms into traces
     WireCell::ITrace::vector traces;
+    raw::RawDigit::ADCvector_t buffer;
     for (unsigned int ich = 0; ich < n_channels; ich++) {
-      if (inputWaveforms.at(ich).NADC() < windowSize) continue;
-
-      const raw::RawDigit::ADCvector_t& rawAdcVec = inputWaveforms.at(ich).ADCs();
-
-      WireCell::ITrace::ChargeSequence charges;
+      if (wcls::RawAdcs::nsamples(inputWaveforms.at(ich)) < windowSize) continue;
 
-      charges.resize(nsamples);
+      const raw::RawDigit::ADCvector_t& rawAdcVec =
+        wcls::RawAdcs::samples(inputWaveforms.at(ich), buffer);
 
-      std::transform(rawAdcVec.begin(), rawAdcVec.end(), charges.begin(), [](auto& adcVal) {
-        return float(adcVal);
-      });
+      WireCell::ITrace::ChargeSequence charges(nsamples, 0.0);
+      std::transform(rawAdcVec.begin(),
+                     rawAdcVec.begin() + std::min(nsamples, rawAdcVec.size()),
+                     charges.begin(),
+                     [](auto adcVal) { return float(adcVal); });
 
       unsigned int chan = inputWaveforms.at(ich).Channel();
-      WireCell::SimpleTrace* st = new WireCell::SimpleTrace(chan, 0.0, charges);
-      traces.push_back(WireCell::ITrace::pointer(st));
+      traces.push_back(std::make_shared<WireCell::SimpleTrace>(chan, 0, charges));
     }
 
     //Load traces into frame
@@ -7,6 +7,9 @@
 #include "lardataobj/RecoBase/Wire.h"
 #include "lardataobj/RawData/RawDigit.h"
 
+#include "larwirecell/Utilities/RawAdcs.h"
+#include "larwirecell/Utilities/Sparsify.h"
+
 namespace butcher {
 
     struct EventButcherConfig {
@@ -124,9 +127,10 @@ void butcher::EventButcher::produce(art::Event & event)
     const double sigscale = m_cfg.sigscale();
 
     // Truncate the raw digits
+    raw::RawDigit::ADCvector_t buffer;
     for (size_t iraw=0; iraw != nraw; ++iraw) {
 	const auto& inrd = raw->at(iraw);
-	const auto& inadcs = inrd.ADCs();
+	const auto& inadcs = wcls::RawAdcs::samples(inrd, buffer);
 	const size_t inlen = inadcs.size();
 
 	const int outlen = std::min(inlen-ndrop, nkeep < 0 ? inlen : nkeep);
@@ -164,23 +168,7 @@ void butcher::EventButcher::produce(art::Event & event)
 
 	// resparsify
 	recob::Wire::RegionsOfInterest_t roi(outlen);
-	auto first = wave.begin()+ndrop;
-	auto done = wave.begin()+ndrop+outlen;
-	auto beg = first;
-	while (true) {
-	    beg = std::find_if(beg, done, [](float v){return v != 0.0;});
-	    if (beg == done) {
-		break;
-	    }
-	    auto end = std::find_if(beg, done, [](float v){return v == 0.0;});
-
-	    std::vector<float> scaled(beg, end);
-	    for (int ind=0; ind<end-beg; ++ind) {
-		scaled[ind] *= sigscale;
-	    }
-	    roi.add_range(beg-first, scaled.begin(), scaled.end());
-	    beg = end;
-	}
+	wcls::Sparsify::add_nonzero_runs(roi, 0, wave.data()+ndrop, outlen, sigscale);
 
 	const size_t outind = outsig->size();
 	outsig->emplace_back(recob::Wire(roi, chid, view));
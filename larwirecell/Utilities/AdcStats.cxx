@@ -0,0 +1,206 @@
+#include "larwirecell/Utilities/AdcStats.h"
+
+#include "WireCellUtil/Waveform.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace wcls;
+
+AdcStats::Histogram::Histogram(int lowest)
+    : m_lanes(nlanes*nadc12, 0)
+    , m_lowest(lowest)
+    , m_top(0)
+    , m_entries(0)
+    , m_outside(0)
+{
+}
+
+void AdcStats::Histogram::clear()
+{
+    // Only bins below m_top may be nonzero.
+    for (size_t lane = 0; lane < nlanes; ++lane) {
+        auto beg = m_lanes.begin() + lane*nadc12;
+        std::fill(beg, beg + m_top, 0);
+    }
+    m_top = 0;
+    m_entries = m_outside = 0;
+}
+
+void AdcStats::Histogram::clear(int lowest)
+{
+    clear();
+    m_lowest = lowest;
+}
+
+void AdcStats::Histogram::fill(const short* adcs, size_t nadcs)
+{
+    uint32_t* h0 = m_lanes.data();
+    uint32_t* h1 = h0 + nadc12;
+    uint32_t* h2 = h1 + nadc12;
+    uint32_t* h3 = h2 + nadc12;
+
+    // Samples are made relative to the window.  An unsigned compare
+    // against its size then catches those below it too.
+    // The OR of in-window samples bounds their maximum from above and
+    // stays in the window, so it tracks the touched bins cheaply.
+    const int lo = m_lowest;
+    size_t outside = 0;
+    uint32_t top = 0;
+    size_t ind = 0;
+    for (; ind + nlanes <= nadcs; ind += nlanes) {
+        const uint32_t a0 = adcs[ind] - lo, a1 = adcs[ind+1] - lo;
+        const uint32_t a2 = adcs[ind+2] - lo, a3 = adcs[ind+3] - lo;
+        const uint32_t any = a0 | a1 | a2 | a3;
+        if (any < nadc12) {
+            ++h0[a0]; ++h1[a1]; ++h2[a2]; ++h3[a3];
+            top |= any;
+            continue;
+        }
+        if (a0 < nadc12) { ++h0[a0]; top |= a0; } else { ++outside; }
+        if (a1 < nadc12) { ++h1[a1]; top |= a1; } else { ++outside; }
+        if (a2 < nadc12) { ++h2[a2]; top |= a2; } else { ++outside; }
+        if (a3 < nadc12) { ++h3[a3]; top |= a3; } else { ++outside; }
+    }
+    for (; ind < nadcs; ++ind) {
+        const uint32_t a = adcs[ind] - lo;
+        if (a < nadc12) { ++h0[a]; top |= a; } else { ++outside; }
+    }
+    if (nadcs > outside) {
+        m_top = std::max<size_t>(m_top, top + 1);
+    }
+    m_entries += nadcs;
+    m_outside += outside;
+}
+
+short AdcStats::Histogram::mode() const
+{
+    const uint32_t* h0 = m_lanes.data();
+    const uint32_t* h1 = h0 + nadc12;
+    const uint32_t* h2 = h1 + nadc12;
+    const uint32_t* h3 = h2 + nadc12;
+
+    uint32_t best = 0;
+    size_t ibest = 0;
+    for (size_t ibin = 0; ibin < m_top; ++ibin) {
+        const uint32_t count = h0[ibin] + h1[ibin] + h2[ibin] + h3[ibin];
+        if (count > best) {
+            best = count;
+            ibest = ibin;
+        }
+    }
+    return ibest + m_lowest;
+}
+
+short AdcStats::Histogram::median() const
+{
+    const uint32_t* h0 = m_lanes.data();
+    const uint32_t* h1 = h0 + nadc12;
+    const uint32_t* h2 = h1 + nadc12;
+    const uint32_t* h3 = h2 + nadc12;
+
+    const size_t half = (m_entries - m_outside + 1)/2;
+    size_t cumulative = 0;
+    for (size_t ibin = 0; ibin < m_top; ++ibin) {
+        cumulative += h0[ibin] + h1[ibin] + h2[ibin] + h3[ibin];
+        if (cumulative >= half) {
+            return ibin + m_lowest;
+        }
+    }
+    return m_lowest;
+}
+
+
+void AdcStats::Moments::add(const short* adcs, size_t nadcs)
+{
+    // Integer sums are exact and vectorize.
+    int64_t sum = 0, sum2 = 0;
+    for (size_t ind = 0; ind < nadcs; ++ind) {
+        const int32_t a = adcs[ind];
+        sum += a;
+        sum2 += a*a;
+    }
+    m_n += nadcs;
+    m_sum += sum;
+    m_sum2 += sum2;
+}
+
+double AdcStats::Moments::mean() const
+{
+    if (!m_n) {
+        return 0.0;
+    }
+    return double(m_sum)/m_n;
+}
+
+double AdcStats::Moments::rms() const
+{
+    if (!m_n) {
+        return 0.0;
+    }
+    const double mu = mean();
+    const double var = double(m_sum2)/m_n - mu*mu;
+    return var > 0.0 ? std::sqrt(var) : 0.0;
+}
+
+
+// Find the minimum and maximum sample in one pass which vectorizes.
+static void minmax(const std::vector<short>& adcs, int& lo, int& hi)
+{
+    short mn = adcs[0], mx = adcs[0];
+    const short* a = adcs.data();
+    const size_t n = adcs.size();
+    for (size_t ind = 0; ind < n; ++ind) {
+        mn = std::min(mn, a[ind]);
+        mx = std::max(mx, a[ind]);
+    }
+    lo = mn;
+    hi = mx;
+}
+
+short AdcStats::mode(const std::vector<short>& adcs)
+{
+    if (adcs.empty()) {
+        return 0;
+    }
+    int lo, hi;
+    minmax(adcs, lo, hi);
+    if (hi - lo >= int(nadc12)) {
+        return WireCell::Waveform::most_frequent(adcs);
+    }
+    thread_local Histogram hist;
+    hist.clear(lo);
+    hist.fill(adcs);
+    return hist.mode();
+}
+
+short AdcStats::median(const std::vector<short>& adcs)
+{
+    if (adcs.empty()) {
+        return 0;
+    }
+    int lo, hi;
+    minmax(adcs, lo, hi);
+    if (hi - lo < int(nadc12)) {
+        thread_local Histogram hist;
+        hist.clear(lo);
+        hist.fill(adcs);
+        return hist.median();
+    }
+    std::vector<short> tmp(adcs);
+    auto mid = tmp.begin() + (tmp.size()-1)/2;
+    std::nth_element(tmp.begin(), mid, tmp.end());
+    return *mid;
+}
+
+double AdcStats::rms(const std::vector<short>& adcs)
+{
+    Moments mom;
+    mom.add(adcs.data(), adcs.size());
+    return mom.rms();
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
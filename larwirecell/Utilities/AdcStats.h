@@ -0,0 +1,102 @@
+/** Fast statistics of ADC waveforms.
+ *
+ * Per-channel baseline estimation runs on every channel of every
+ * event so these are linear passes specialized for ADC values held
+ * in a short which span no more than 12 bits.  The span need not
+ * start at zero, eg baseline subtracted waveforms are negative.
+ * Waveforms spanning more than 12 bits are tolerated but make the
+ * mode and median fall back to a general purpose (and slower)
+ * estimate.
+ */
+
+#ifndef LARWIRECELL_UTILITIES_ADCSTATS
+#define LARWIRECELL_UTILITIES_ADCSTATS
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wcls {
+    namespace AdcStats {
+
+        /// The number of distinct 12 bit ADC values.
+        const size_t nadc12 = 4096;
+
+        /// A histogram of a window of nadc12 ADC values starting at
+        /// lowest which may be filled incrementally and queried at
+        /// any time.  Reuse one instance with clear() to avoid
+        /// reallocation.  Only the bins up to the highest value
+        /// filled are cleared and scanned, so a narrow waveform
+        /// costs little however wide the window.
+        class Histogram {
+        public:
+            explicit Histogram(int lowest = 0);
+
+            /// Reset to empty, optionally moving the window.
+            void clear();
+            void clear(int lowest);
+
+            /// The first value of the window.
+            int lowest() const { return m_lowest; }
+
+            /// Add samples.  The fill interleaves several partial
+            /// histograms so that runs of equal values (ie, a flat
+            /// baseline) do not serialize on one bin.
+            void fill(const short* adcs, size_t nadcs);
+            void fill(const std::vector<short>& adcs) { fill(adcs.data(), adcs.size()); }
+
+            /// Number of samples filled, and number outside of the
+            /// window.  Samples outside are only counted.
+            size_t entries() const { return m_entries; }
+            size_t outside() const { return m_outside; }
+
+            /// The most frequent in-window value, lowest wins ties.
+            short mode() const;
+
+            /// The lowest in-window value with at least half of the
+            /// in-window samples at or below it.
+            short median() const;
+
+        private:
+            static const size_t nlanes = 4;
+            std::vector<uint32_t> m_lanes; // nlanes x nadc12
+            int m_lowest;
+            size_t m_top; // one past the highest bin touched
+            size_t m_entries, m_outside;
+        };
+
+        /// Accumulate mean and RMS one sample or one block at a time.
+        class Moments {
+        public:
+            Moments() : m_n(0), m_sum(0), m_sum2(0) {}
+
+            void add(short adc) { ++m_n; m_sum += adc; m_sum2 += int64_t(adc)*adc; }
+            void add(const short* adcs, size_t nadcs);
+
+            size_t count() const { return m_n; }
+            double mean() const;
+            double rms() const;
+
+        private:
+            size_t m_n;
+            int64_t m_sum, m_sum2;
+        };
+
+        /// Single call versions.  These consider all samples: the
+        /// histogram window is placed at the minimum sample and if
+        /// the samples span more than nadc12 values the mode is
+        /// found by Waveform::most_frequent() and the median by a
+        /// partial sort.  Unlike a Histogram's median(), out of
+        /// window samples thus count toward the median.
+        short mode(const std::vector<short>& adcs);
+        short median(const std::vector<short>& adcs);
+        double rms(const std::vector<short>& adcs);
+    }
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
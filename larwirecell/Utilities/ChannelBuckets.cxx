@@ -0,0 +1,48 @@
+#include "larwirecell/Utilities/ChannelBuckets.h"
+
+using namespace wcls;
+
+void ChannelBuckets::set_slot(std::vector<int>& chslot, int chid, int slot)
+{
+    if (chid < 0) {
+        return;
+    }
+    if ((size_t)chid >= chslot.size()) {
+        chslot.resize(chid+1, -1);
+    }
+    chslot[chid] = slot;
+}
+
+void ChannelBuckets::bucket_by_slot(const WireCell::ITrace::vector& traces,
+                                    const std::vector<int>& chslot, size_t nslots,
+                                    buckets_t& ret)
+{
+    const size_t ntraces = traces.size();
+    std::vector<int> slots(ntraces, -1);
+    ret.offset.assign(nslots+1, 0);
+    for (size_t itrace = 0; itrace < ntraces; ++itrace) {
+        const int slot = slot_of(chslot, traces[itrace]->channel());
+        if (slot < 0) {
+            continue;
+        }
+        slots[itrace] = slot;
+        ++ret.offset[slot+1];
+    }
+    for (size_t slot = 0; slot < nslots; ++slot) {
+        ret.offset[slot+1] += ret.offset[slot];
+    }
+    ret.index.resize(ret.offset[nslots]);
+    std::vector<size_t> fill(ret.offset.begin(), ret.offset.end()-1);
+    for (size_t itrace = 0; itrace < ntraces; ++itrace) {
+        const int slot = slots[itrace];
+        if (slot < 0) {
+            continue;
+        }
+        ret.index[fill[slot]++] = itrace;
+    }
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
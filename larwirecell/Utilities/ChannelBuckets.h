@@ -0,0 +1,55 @@
+/** Grouping of traces by channel.
+ *
+ * Channels are given dense "slots" through a lookup vector indexed by
+ * channel ID which holds -1 for channels without a slot.  Traces are
+ * then bucketed by slot in a compressed sparse row layout, in two
+ * linear passes and with no per-channel allocation, so that each
+ * channel's traces may be merged independently (and in parallel).
+ */
+
+#ifndef LARWIRECELL_UTILITIES_CHANNELBUCKETS
+#define LARWIRECELL_UTILITIES_CHANNELBUCKETS
+
+#include "WireCellIface/ITrace.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace wcls {
+    namespace ChannelBuckets {
+
+        /// Return the slot of a channel or -1 if it has none.
+        inline int slot_of(const std::vector<int>& chslot, int chid) {
+            if (chid < 0 or (size_t)chid >= chslot.size()) {
+                return -1;
+            }
+            return chslot[chid];
+        }
+
+        /// Give a channel the slot, growing the lookup as needed.
+        void set_slot(std::vector<int>& chslot, int chid, int slot);
+
+        /// The traces of slot s are at index[offset[s]] through
+        /// index[offset[s+1]-1], given as indices into the bucketed
+        /// sequence, in their original order.
+        struct buckets_t {
+            std::vector<size_t> offset;
+            std::vector<size_t> index;
+
+            size_t size(size_t slot) const { return offset[slot+1] - offset[slot]; }
+        };
+
+        /// Bucket the traces by the slots of their channels.
+        /// Traces of channels without a slot are left out.
+        void bucket_by_slot(const WireCell::ITrace::vector& traces,
+                            const std::vector<int>& chslot, size_t nslots,
+                            buckets_t& ret);
+    }
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
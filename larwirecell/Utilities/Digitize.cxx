@@ -0,0 +1,70 @@
+#include "larwirecell/Utilities/Digitize.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace wcls;
+
+// Clamp in float so the integer conversion can not overflow.  The
+// compares are ordered as SSE max/min so a NaN becomes lo here too.
+static inline float clamp(float v, float lo, float hi)
+{
+    v = v > lo ? v : lo;
+    return v < hi ? v : hi;
+}
+
+void Digitize::digitize(const float* in, size_t n, short* out, const Params& params)
+{
+    const float lo = params.adc_min;
+    const float hi = params.adc_max;
+    const bool trunc = params.rounding == kTruncate;
+    size_t ind = 0;
+#if defined(__SSE2__)
+    // Default MXCSR rounding is to nearest even, as is nearbyint().
+    const __m128 vscale = _mm_set1_ps(params.scale);
+    const __m128 vlo = _mm_set1_ps(lo);
+    const __m128 vhi = _mm_set1_ps(hi);
+    for (; ind + 8 <= n; ind += 8) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(in + ind), vscale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(in + ind + 4), vscale);
+        a = _mm_min_ps(_mm_max_ps(a, vlo), vhi);
+        b = _mm_min_ps(_mm_max_ps(b, vlo), vhi);
+        const __m128i ia = trunc ? _mm_cvttps_epi32(a) : _mm_cvtps_epi32(a);
+        const __m128i ib = trunc ? _mm_cvttps_epi32(b) : _mm_cvtps_epi32(b);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + ind), _mm_packs_epi32(ia, ib));
+    }
+#endif
+    for (; ind < n; ++ind) {
+        const float v = clamp(in[ind] * params.scale, lo, hi);
+        out[ind] = trunc ? static_cast<short>(v) : static_cast<short>(std::nearbyint(v));
+    }
+}
+
+void Digitize::accumulate(std::vector<float>& wave, int tbin, const float* in, size_t n)
+{
+    const int nwave = wave.size();
+    if (tbin >= nwave) {
+        return;
+    }
+    // Clip to the wave before forming any pointer into it.
+    const int beg = tbin < 0 ? -tbin : 0;
+    const int end = std::min<long>(n, nwave - tbin);
+    if (beg >= end) {
+        return;
+    }
+    float* dst = wave.data() + (tbin + beg);
+    const float* src = in + beg;
+    const int len = end - beg;
+    for (int ind = 0; ind < len; ++ind) {
+        dst[ind] += src[ind];
+    }
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
@@ -0,0 +1,44 @@
+/** Conversion of float waveforms to ADC samples.
+ *
+ * A waveform is scaled, rounded (or truncated) and saturated to an
+ * ADC range in a single pass which uses SIMD where available.
+ */
+
+#ifndef LARWIRECELL_UTILITIES_DIGITIZE
+#define LARWIRECELL_UTILITIES_DIGITIZE
+
+#include <cstddef>
+#include <vector>
+
+namespace wcls {
+    namespace Digitize {
+
+        /// How a scaled sample becomes an integer.  Round goes to
+        /// the nearest integer, halfway values to the even one.
+        /// Truncate goes toward zero as does a C++ cast.
+        enum Rounding { kRound, kTruncate };
+
+        struct Params {
+            float scale{1.0};
+            Rounding rounding{kRound};
+            // Saturation range, inclusive.
+            short adc_min{-32768}, adc_max{32767};
+        };
+
+        /// Write n samples of in, digitized, to out.  A NaN sample
+        /// becomes adc_min.
+        void digitize(const float* in, size_t n, short* out, const Params& params);
+
+        /// Add the n samples of in to the waveform wave starting at
+        /// tbin, which may be negative.  Samples falling before the
+        /// start or beyond the end of wave are dropped.
+        void accumulate(std::vector<float>& wave, int tbin, const float* in, size_t n);
+    }
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
@@ -0,0 +1,250 @@
+#include "larwirecell/Utilities/NpzWriter.h"
+
+#include "WireCellUtil/Exceptions.h"
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace wcls;
+using namespace WireCell;
+
+// Bytes held before a write to the file.
+static const size_t buffer_size = 1 << 20;
+
+// zip record signatures
+static const uint32_t local_sig = 0x04034b50;
+static const uint32_t descriptor_sig = 0x08074b50;
+static const uint32_t central_sig = 0x02014b50;
+static const uint32_t end_sig = 0x06054b50;
+
+// version 2.0, data descriptor follows, stored, 1980-01-01 00:00
+static const uint16_t zip_version = 20;
+static const uint16_t zip_flags = 0x0008;
+static const uint16_t zip_stored = 0;
+static const uint16_t zip_time = 0;
+static const uint16_t zip_date = (0 << 9) | (1 << 5) | 1;
+
+// CRC-32 as used by zip, one byte at a time from a table.
+static const uint32_t* crc_table()
+{
+    static const struct table_t {
+        uint32_t val[256];
+        table_t()
+        {
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                val[n] = c;
+            }
+        }
+    } table;
+    return table.val;
+}
+
+static uint32_t crc_update(uint32_t crc, const unsigned char* data, size_t n)
+{
+    const uint32_t* table = crc_table();
+    crc = ~crc;
+    for (size_t ind = 0; ind < n; ++ind) {
+        crc = table[(crc ^ data[ind]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+NpzWriter::NpzWriter(const std::string& filename)
+    : m_filename(filename)
+    , m_out(filename, std::ios::binary | std::ios::trunc)
+    , m_open(true)
+    , m_inarray(false)
+    , m_pos(0)
+    , m_crc(0)
+    , m_size(0)
+{
+    if (!m_out) {
+        THROW(IOError() << errmsg{"NpzWriter: failed to open " + filename});
+    }
+    m_buffer.reserve(buffer_size);
+}
+
+NpzWriter::~NpzWriter()
+{
+    if (!m_open) {
+        return;
+    }
+    try {
+        close();
+    }
+    catch (const std::exception& err) {
+        std::cerr << "NpzWriter: failed to close " << m_filename << ": " << err.what() << "\n";
+    }
+    catch (...) {
+        std::cerr << "NpzWriter: failed to close " << m_filename << "\n";
+    }
+}
+
+void NpzWriter::flush()
+{
+    m_out.write(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+    if (!m_out) {
+        THROW(IOError() << errmsg{"NpzWriter: failed to write " + m_filename});
+    }
+}
+
+void NpzWriter::put(const void* data, size_t nbytes)
+{
+    if (m_pos + nbytes > std::numeric_limits<uint32_t>::max()) {
+        THROW(IOError() << errmsg{"NpzWriter: file too large for zip: " + m_filename});
+    }
+    m_pos += nbytes;
+    const char* bytes = static_cast<const char*>(data);
+    if (nbytes >= buffer_size) {
+        flush();
+        m_out.write(bytes, nbytes);
+        return;
+    }
+    if (m_buffer.size() + nbytes > buffer_size) {
+        flush();
+    }
+    m_buffer.insert(m_buffer.end(), bytes, bytes + nbytes);
+}
+
+// zip is little endian
+void NpzWriter::put16(uint16_t val)
+{
+    const unsigned char b[2] = {static_cast<unsigned char>(val),
+                                static_cast<unsigned char>(val >> 8)};
+    put(b, 2);
+}
+
+void NpzWriter::put32(uint32_t val)
+{
+    put16(val & 0xffff);
+    put16(val >> 16);
+}
+
+void NpzWriter::begin_array(const std::string& name, const std::string& descr,
+                            const std::vector<size_t>& shape)
+{
+    if (!m_open or m_inarray) {
+        THROW(LogicError() << errmsg{"NpzWriter: can not begin array " + name});
+    }
+    entry_t entry{name + ".npy", 0, 0, static_cast<uint32_t>(m_pos)};
+
+    put32(local_sig);
+    put16(zip_version);
+    put16(zip_flags);
+    put16(zip_stored);
+    put16(zip_time);
+    put16(zip_date);
+    put32(0); // crc, size and compressed size are in the descriptor
+    put32(0);
+    put32(0);
+    put16(entry.name.size());
+    put16(0);
+    put(entry.name.data(), entry.name.size());
+    m_entries.push_back(entry);
+
+    m_inarray = true;
+    m_crc = 0;
+    m_size = 0;
+
+    // .npy version 1.0 header, padded so data is 64 byte aligned
+    std::stringstream ss;
+    ss << "{'descr': '" << descr << "', 'fortran_order': False, 'shape': (";
+    for (size_t dim : shape) {
+        ss << dim << ", ";
+    }
+    ss << "), }";
+    std::string header = ss.str();
+    const size_t preamble = 10;
+    const size_t total = (preamble + header.size() + 1 + 63) / 64 * 64;
+    header.append(total - preamble - header.size() - 1, ' ');
+    header.push_back('\n');
+
+    const char magic[8] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0};
+    write(magic, 8);
+    const unsigned char hlen[2] = {static_cast<unsigned char>(header.size()),
+                                   static_cast<unsigned char>(header.size() >> 8)};
+    write(hlen, 2);
+    write(header.data(), header.size());
+}
+
+void NpzWriter::write(const void* data, size_t nbytes)
+{
+    if (!m_inarray) {
+        THROW(LogicError() << errmsg{"NpzWriter: write outside of an array"});
+    }
+    m_crc = crc_update(m_crc, static_cast<const unsigned char*>(data), nbytes);
+    m_size += nbytes;
+    put(data, nbytes);
+}
+
+void NpzWriter::end_array()
+{
+    if (!m_inarray) {
+        THROW(LogicError() << errmsg{"NpzWriter: no array to end"});
+    }
+    auto& entry = m_entries.back();
+    entry.crc = m_crc;
+    entry.size = m_size;
+    put32(descriptor_sig);
+    put32(entry.crc);
+    put32(entry.size);
+    put32(entry.size);
+    m_inarray = false;
+}
+
+void NpzWriter::close()
+{
+    if (!m_open) {
+        return;
+    }
+    if (m_inarray) {
+        end_array();
+    }
+    // No second attempt if this fails part way.
+    m_open = false;
+    const uint64_t cdoffset = m_pos;
+    for (const auto& entry : m_entries) {
+        put32(central_sig);
+        put16(zip_version);
+        put16(zip_version);
+        put16(zip_flags);
+        put16(zip_stored);
+        put16(zip_time);
+        put16(zip_date);
+        put32(entry.crc);
+        put32(entry.size);
+        put32(entry.size);
+        put16(entry.name.size());
+        put16(0); // extra
+        put16(0); // comment
+        put16(0); // disk
+        put16(0); // internal attributes
+        put32(0); // external attributes
+        put32(entry.offset);
+        put(entry.name.data(), entry.name.size());
+    }
+    const uint64_t cdsize = m_pos - cdoffset;
+    put32(end_sig);
+    put16(0);
+    put16(0);
+    put16(m_entries.size());
+    put16(m_entries.size());
+    put32(cdsize);
+    put32(cdoffset);
+    put16(0);
+    flush();
+    m_out.close();
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
@@ -0,0 +1,94 @@
+/** A streaming writer of NumPy .npz files.
+ *
+ * Arrays are written one after another as uncompressed ("stored")
+ * zip entries holding .npy data, as numpy.savez() makes.  Data is
+ * buffered and streamed to the file as it is given so an array need
+ * not exist whole in memory.  The CRC and sizes of each entry follow
+ * its data in a zip data descriptor.  There are no dependencies
+ * beyond the standard library.  Zip64 is not supported so the file
+ * must stay below 4 GiB.
+ */
+
+#ifndef LARWIRECELL_UTILITIES_NPZWRITER
+#define LARWIRECELL_UTILITIES_NPZWRITER
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace wcls {
+
+    class NpzWriter {
+    public:
+        /// Open the file for writing, throwing IOError on failure.
+        explicit NpzWriter(const std::string& filename);
+
+        /// Close if not already closed.  Errors are reported but
+        /// can not be thrown from here: call close() to see them.
+        ~NpzWriter();
+
+        /// Start an array of the given NumPy dtype description (eg
+        /// "<f4") and C-order shape.  It is named "name.npy" in the
+        /// archive and loads as "name".
+        void begin_array(const std::string& name, const std::string& descr,
+                         const std::vector<size_t>& shape);
+
+        /// Append raw bytes of the current array.
+        void write(const void* data, size_t nbytes);
+
+        /// Finish the current array.
+        void end_array();
+
+        /// Write a whole array.
+        template <typename T>
+        void add(const std::string& name, const std::vector<T>& data,
+                 const std::vector<size_t>& shape)
+        {
+            begin_array(name, descr<T>(), shape);
+            write(data.data(), data.size() * sizeof(T));
+            end_array();
+        }
+
+        /// Write the zip central directory and close the file.
+        /// Throws IOError on a failure to write.
+        void close();
+
+        /// The NumPy dtype description of a few types.
+        template <typename T>
+        static std::string descr();
+
+    private:
+        struct entry_t {
+            std::string name;
+            uint32_t crc, size, offset;
+        };
+
+        std::string m_filename;
+        std::ofstream m_out;
+        std::vector<char> m_buffer;
+        std::vector<entry_t> m_entries;
+        bool m_open, m_inarray;
+        uint64_t m_pos;
+        uint32_t m_crc;
+        uint64_t m_size;
+
+        void flush();
+        void put(const void* data, size_t nbytes);
+        void put16(uint16_t val);
+        void put32(uint32_t val);
+    };
+
+    template <> inline std::string NpzWriter::descr<float>() { return "<f4"; }
+    template <> inline std::string NpzWriter::descr<double>() { return "<f8"; }
+    template <> inline std::string NpzWriter::descr<short>() { return "<i2"; }
+    template <> inline std::string NpzWriter::descr<int>() { return "<i4"; }
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
@@ -0,0 +1,31 @@
+#include "larwirecell/Utilities/RawAdcs.h"
+
+#include "lardataobj/RawData/raw.h"
+
+#include <cmath>
+
+using namespace wcls;
+
+const raw::RawDigit::ADCvector_t& RawAdcs::samples(const raw::RawDigit& rd,
+                                                   raw::RawDigit::ADCvector_t& buffer)
+{
+    if (rd.Compression() == raw::kNone) {
+        return rd.ADCs();
+    }
+    buffer.resize(rd.Samples());
+    raw::Uncompress(rd.ADCs(), buffer, std::lround(rd.GetPedestal()), rd.Compression());
+    return buffer;
+}
+
+size_t RawAdcs::nsamples(const raw::RawDigit& rd)
+{
+    if (rd.Compression() == raw::kNone) {
+        return rd.ADCs().size();
+    }
+    return rd.Samples();
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
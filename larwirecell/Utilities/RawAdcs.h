@@ -0,0 +1,33 @@
+/** Access to the ADC samples of a raw::RawDigit whatever its compression.
+ *
+ * RawDigit::ADCs() holds the compressed words if the digit was
+ * saved with compression (eg, by FrameSaver's "compression"
+ * option).  Readers which want samples should go through here.
+ */
+
+#ifndef LARWIRECELL_UTILITIES_RAWADCS
+#define LARWIRECELL_UTILITIES_RAWADCS
+
+#include "lardataobj/RawData/RawDigit.h"
+
+namespace wcls {
+    namespace RawAdcs {
+
+        /// Return the uncompressed samples of the digit.  That is
+        /// ADCs() itself if it is not compressed, else buffer, which
+        /// is filled with Samples() samples.  Zero suppressed gaps
+        /// are filled with the digit's pedestal.
+        const raw::RawDigit::ADCvector_t& samples(const raw::RawDigit& rd,
+                                                  raw::RawDigit::ADCvector_t& buffer);
+
+        /// The number of uncompressed samples of the digit.
+        size_t nsamples(const raw::RawDigit& rd);
+    }
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
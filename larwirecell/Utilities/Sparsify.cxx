@@ -0,0 +1,130 @@
+#include "larwirecell/Utilities/Sparsify.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace wcls;
+
+#if defined(__SSE2__)
+// Bit i of the mask is set if lane i of the block of 4 matches.
+static inline int nonzero_mask(const float* p)
+{
+    return _mm_movemask_ps(_mm_cmpneq_ps(_mm_loadu_ps(p), _mm_setzero_ps()));
+}
+
+// Bit i of the mask is set if lane i of the block of 4 has a
+// magnitude above the threshold.
+static inline int above_mask(const float* p, __m128 thresh)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 mag = _mm_andnot_ps(sign, _mm_loadu_ps(p));
+    return _mm_movemask_ps(_mm_cmpgt_ps(mag, thresh));
+}
+#endif
+
+size_t Sparsify::find_nonzero(const float* data, size_t beg, size_t n)
+{
+    size_t ind = beg;
+#if defined(__SSE2__)
+    for (; ind + 4 <= n; ind += 4) {
+        const int mask = nonzero_mask(data + ind);
+        if (mask) {
+            return ind + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; ind < n; ++ind) {
+        if (data[ind] != 0.0f) {
+            return ind;
+        }
+    }
+    return n;
+}
+
+size_t Sparsify::find_zero(const float* data, size_t beg, size_t n)
+{
+    size_t ind = beg;
+#if defined(__SSE2__)
+    for (; ind + 4 <= n; ind += 4) {
+        const int mask = ~nonzero_mask(data + ind) & 0xf;
+        if (mask) {
+            return ind + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; ind < n; ++ind) {
+        if (data[ind] == 0.0f) {
+            return ind;
+        }
+    }
+    return n;
+}
+
+size_t Sparsify::find_above(const float* data, size_t beg, size_t n, float threshold)
+{
+    size_t ind = beg;
+#if defined(__SSE2__)
+    const __m128 thresh = _mm_set1_ps(threshold);
+    for (; ind + 4 <= n; ind += 4) {
+        const int mask = above_mask(data + ind, thresh);
+        if (mask) {
+            return ind + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; ind < n; ++ind) {
+        if (std::abs(data[ind]) > threshold) {
+            return ind;
+        }
+    }
+    return n;
+}
+
+size_t Sparsify::find_not_above(const float* data, size_t beg, size_t n, float threshold)
+{
+    size_t ind = beg;
+#if defined(__SSE2__)
+    const __m128 thresh = _mm_set1_ps(threshold);
+    for (; ind + 4 <= n; ind += 4) {
+        const int mask = ~above_mask(data + ind, thresh) & 0xf;
+        if (mask) {
+            return ind + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; ind < n; ++ind) {
+        if (!(std::abs(data[ind]) > threshold)) {
+            return ind;
+        }
+    }
+    return n;
+}
+
+void Sparsify::threshold_runs(const float* data, size_t n, const Threshold& thr, runs_t& runs)
+{
+    runs.clear();
+    size_t beg = find_above(data, 0, n, thr.threshold);
+    while (beg < n) {
+        const size_t end = find_not_above(data, beg, n, thr.threshold);
+        if (end - beg >= thr.min_length) {
+            const size_t pbeg = beg > thr.pre ? beg - thr.pre : 0;
+            const size_t pend = std::min(n, end + thr.post);
+            if (!runs.empty() and pbeg <= runs.back().second) {
+                runs.back().second = pend;
+            }
+            else {
+                runs.emplace_back(pbeg, pend);
+            }
+        }
+        beg = find_above(data, end, n, thr.threshold);
+    }
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End:
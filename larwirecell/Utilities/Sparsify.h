@@ -0,0 +1,159 @@
+/** Zero suppression of float waveforms into sparse ROIs.
+ *
+ * Either exact zeros are removed or, given a Threshold, only padded
+ * regions of samples with magnitude above the threshold are kept.
+ *
+ * Finding the boundaries of the runs of nonzero samples is done with
+ * SIMD compares where available.  Each run is scaled as it is copied
+ * into the storage of the ROI container, through scaled_iterator, so
+ * that no intermediate copy is made.
+ */
+
+#ifndef LARWIRECELL_UTILITIES_SPARSIFY
+#define LARWIRECELL_UTILITIES_SPARSIFY
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace wcls {
+    namespace Sparsify {
+
+        /// Return the index of the first sample at or after beg
+        /// which is not zero (NaN counts as not zero), or n if none.
+        size_t find_nonzero(const float* data, size_t beg, size_t n);
+
+        /// Return the index of the first sample at or after beg
+        /// which is zero, or n if none.
+        size_t find_zero(const float* data, size_t beg, size_t n);
+
+        /// Return the index of the first sample at or after beg
+        /// with magnitude above threshold, or n if none.
+        size_t find_above(const float* data, size_t beg, size_t n, float threshold);
+
+        /// Return the index of the first sample at or after beg
+        /// with magnitude not above threshold, or n if none.
+        size_t find_not_above(const float* data, size_t beg, size_t n, float threshold);
+
+        /// Parameters of threshold zero suppression.  A region of
+        /// consecutive samples with magnitude above threshold is
+        /// kept if it is at least min_length long and is then
+        /// widened by pre and post samples.  Widened regions which
+        /// overlap or touch are merged.
+        struct Threshold {
+            float threshold{0.0};
+            size_t pre{0}, post{0}, min_length{0};
+        };
+
+        /// Half open [begin,end) sample ranges.
+        typedef std::vector<std::pair<size_t, size_t>> runs_t;
+
+        /// Fill runs with the kept, padded regions of data[0,n).
+        void threshold_runs(const float* data, size_t n, const Threshold& thr, runs_t& runs);
+
+        /// A random access iterator over samples which yields each
+        /// multiplied by a scale.  Passed to a container's range
+        /// insertion it writes the scaled samples straight into the
+        /// container's storage.
+        class scaled_iterator {
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef float value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const float* pointer;
+            typedef float reference;
+
+            scaled_iterator(const float* ptr, float scale) : m_ptr(ptr), m_scale(scale) {}
+
+            float operator*() const { return *m_ptr * m_scale; }
+            float operator[](difference_type n) const { return m_ptr[n] * m_scale; }
+
+            scaled_iterator& operator++() { ++m_ptr; return *this; }
+            scaled_iterator& operator--() { --m_ptr; return *this; }
+            scaled_iterator operator++(int) { scaled_iterator ret(*this); ++m_ptr; return ret; }
+            scaled_iterator operator--(int) { scaled_iterator ret(*this); --m_ptr; return ret; }
+            scaled_iterator& operator+=(difference_type n) { m_ptr += n; return *this; }
+            scaled_iterator& operator-=(difference_type n) { m_ptr -= n; return *this; }
+            scaled_iterator operator+(difference_type n) const {
+                return scaled_iterator(m_ptr + n, m_scale);
+            }
+            scaled_iterator operator-(difference_type n) const {
+                return scaled_iterator(m_ptr - n, m_scale);
+            }
+            difference_type operator-(const scaled_iterator& other) const {
+                return m_ptr - other.m_ptr;
+            }
+
+            bool operator==(const scaled_iterator& other) const { return m_ptr == other.m_ptr; }
+            bool operator!=(const scaled_iterator& other) const { return m_ptr != other.m_ptr; }
+            bool operator<(const scaled_iterator& other) const { return m_ptr < other.m_ptr; }
+            bool operator>(const scaled_iterator& other) const { return m_ptr > other.m_ptr; }
+            bool operator<=(const scaled_iterator& other) const { return m_ptr <= other.m_ptr; }
+            bool operator>=(const scaled_iterator& other) const { return m_ptr >= other.m_ptr; }
+
+        private:
+            const float* m_ptr;
+            float m_scale;
+        };
+
+        /// Add data[beg,end), multiplied by scale, to rois at index
+        /// offset plus beg.  The ROIs container must provide
+        /// add_range(index, first, last) as does
+        /// lar::sparse_vector<float>.  If given, qsum accumulates the
+        /// sum of the scaled samples.  Return the number of samples
+        /// added.
+        template <typename ROIs>
+        size_t add_scaled(ROIs& rois, size_t offset, const float* data, size_t beg, size_t end,
+                          float scale = 1.0, double* qsum = nullptr)
+        {
+            if (qsum) {
+                for (size_t ind = beg; ind < end; ++ind) {
+                    *qsum += data[ind] * scale;
+                }
+            }
+            rois.add_range(offset + beg, scaled_iterator(data + beg, scale),
+                           scaled_iterator(data + end, scale));
+            return end - beg;
+        }
+
+        /// Add each run of nonzero samples of data[0,n) with
+        /// add_scaled().
+        template <typename ROIs>
+        size_t add_nonzero_runs(ROIs& rois, size_t offset, const float* data, size_t n,
+                                float scale = 1.0, double* qsum = nullptr)
+        {
+            size_t nadded = 0;
+            size_t beg = find_nonzero(data, 0, n);
+            while (beg < n) {
+                const size_t end = find_zero(data, beg, n);
+                nadded += add_scaled(rois, offset, data, beg, end, scale, qsum);
+                beg = find_nonzero(data, end, n);
+            }
+            return nadded;
+        }
+
+        /// As add_nonzero_runs() but keep the regions selected by
+        /// threshold_runs().
+        template <typename ROIs>
+        size_t add_threshold_runs(ROIs& rois, size_t offset, const float* data, size_t n,
+                                  const Threshold& thr, float scale = 1.0,
+                                  double* qsum = nullptr)
+        {
+            runs_t runs;
+            threshold_runs(data, n, thr, runs);
+            size_t nadded = 0;
+            for (const auto& r : runs) {
+                nadded += add_scaled(rois, offset, data, r.first, r.second, scale, qsum);
+            }
+            return nadded;
+        }
+    }
+}
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 4
+// End: